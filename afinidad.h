@@ -0,0 +1,207 @@
+#ifndef AFINIDAD_H
+#define AFINIDAD_H
+
+// Requiere _GNU_SOURCE antes del primer #include del .c (cpu_set_t, sched_setaffinity)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>    // MPOL_BIND (sin depender de libnuma)
+
+// Fijacion de trabajadores a CPUs. El lanzador arma una vez el orden de CPUs
+// segun la politica y el trabajador i se fija a orden[(desde + i) % n].
+//   compacta : llena un socket (y cada nucleo con sus hilos SMT) antes de pasar al siguiente
+//   dispersa : reparte entre sockets y nucleos distintos antes de repetir hermanos SMT
+//   lista    : mapa explicito "0,2,4-7" en el orden dado
+//   nodo:N   : CPUs del nodo NUMA N, en orden compacto
+
+#define AFINIDAD_NINGUNA  0
+#define AFINIDAD_COMPACTA 1
+#define AFINIDAD_DISPERSA 2
+#define AFINIDAD_LISTA    3
+#define AFINIDAD_NODO     4
+
+struct Afinidad {
+    int politica;
+    int desde;                      // Desplazamiento en el orden (para no solapar lanzadores)
+    int nodo;                       // Solo AFINIDAD_NODO
+    int n_cpus;
+    int cpus[CPU_SETSIZE];          // Orden en que se asignan las CPUs
+};
+
+// Topologia de una CPU leida de sysfs
+struct CpuTopologia {
+    int cpu, paquete, nucleo, hilo;
+};
+
+static inline int afinidad_leer_entero(const char *ruta, int defecto) {
+    FILE *f = fopen(ruta, "r");
+    if (f == NULL) return defecto;
+    int valor;
+    if (fscanf(f, "%d", &valor) != 1) valor = defecto;
+    fclose(f);
+    return valor;
+}
+
+// Parsea una lista de CPUs en formato del kernel ("0-3,8,10-11"). Devuelve la cantidad o -1.
+static inline int afinidad_parsear_lista(const char *texto, int *cpus, int max) {
+    int n = 0;
+    const char *p = texto;
+    while (*p != '\0' && *p != '\n') {
+        char *fin;
+        long a = strtol(p, &fin, 10);
+        if (fin == p || a < 0 || a >= CPU_SETSIZE) return -1;
+        long b = a;
+        if (*fin == '-') {
+            p = fin + 1;
+            b = strtol(p, &fin, 10);
+            if (fin == p || b < a || b >= CPU_SETSIZE) return -1;
+        }
+        for (long c = a; c <= b; c++) {
+            if (n == max) return -1;
+            cpus[n++] = (int)c;
+        }
+        p = fin;
+        if (*p == ',') p++;
+        else if (*p != '\0' && *p != '\n') return -1;
+    }
+    return n;
+}
+
+static inline int afinidad_comparar_compacta(const void *a, const void *b) {
+    const struct CpuTopologia *x = a, *y = b;
+    if (x->paquete != y->paquete) return x->paquete - y->paquete;
+    if (x->nucleo != y->nucleo) return x->nucleo - y->nucleo;
+    if (x->hilo != y->hilo) return x->hilo - y->hilo;
+    return x->cpu - y->cpu;
+}
+
+static inline int afinidad_comparar_dispersa(const void *a, const void *b) {
+    const struct CpuTopologia *x = a, *y = b;
+    if (x->hilo != y->hilo) return x->hilo - y->hilo;
+    if (x->nucleo != y->nucleo) return x->nucleo - y->nucleo;
+    if (x->paquete != y->paquete) return x->paquete - y->paquete;
+    return x->cpu - y->cpu;
+}
+
+// Ordena las CPUs permitidas segun la topologia (hilo = rango SMT dentro de su nucleo)
+static inline void afinidad_ordenar(struct Afinidad *a, const cpu_set_t *permitidas, int dispersa) {
+    static struct CpuTopologia topo[CPU_SETSIZE];
+    int n = 0;
+    char ruta[128];
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, permitidas)) continue;
+        snprintf(ruta, sizeof(ruta), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+        topo[n].paquete = afinidad_leer_entero(ruta, 0);
+        snprintf(ruta, sizeof(ruta), "/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+        topo[n].nucleo = afinidad_leer_entero(ruta, cpu);
+        topo[n].cpu = cpu;
+        topo[n].hilo = 0;
+        for (int j = 0; j < n; j++) {
+            if (topo[j].paquete == topo[n].paquete && topo[j].nucleo == topo[n].nucleo) topo[n].hilo++;
+        }
+        n++;
+    }
+    qsort(topo, n, sizeof(topo[0]), dispersa ? afinidad_comparar_dispersa : afinidad_comparar_compacta);
+    for (int i = 0; i < n; i++) a->cpus[i] = topo[i].cpu;
+    a->n_cpus = n;
+}
+
+// Interpreta la politica de --cpus. Devuelve 0 o -1 si el texto no es valido.
+static inline int afinidad_parsear(struct Afinidad *a, const char *texto) {
+    a->n_cpus = 0;
+    if (strcmp(texto, "compacta") == 0 || strcmp(texto, "compact") == 0) {
+        a->politica = AFINIDAD_COMPACTA;
+    } else if (strcmp(texto, "dispersa") == 0 || strcmp(texto, "scatter") == 0) {
+        a->politica = AFINIDAD_DISPERSA;
+    } else if (strncmp(texto, "nodo:", 5) == 0) {
+        char *fin;
+        a->politica = AFINIDAD_NODO;
+        a->nodo = (int)strtol(texto + 5, &fin, 10);
+        if (fin == texto + 5 || *fin != '\0' || a->nodo < 0) return -1;
+    } else {
+        a->politica = AFINIDAD_LISTA;
+        a->n_cpus = afinidad_parsear_lista(texto, a->cpus, CPU_SETSIZE);
+        if (a->n_cpus <= 0) return -1;
+    }
+    return 0;
+}
+
+// Arma el orden final de CPUs restringido a las que el lanzador tiene permitidas
+static inline void afinidad_preparar(struct Afinidad *a) {
+    if (a->politica == AFINIDAD_NINGUNA || a->politica == AFINIDAD_LISTA) return;
+
+    cpu_set_t permitidas;
+    if (sched_getaffinity(0, sizeof(permitidas), &permitidas) == -1) {
+        perror("sched_getaffinity");
+        exit(EXIT_FAILURE);
+    }
+
+    if (a->politica == AFINIDAD_NODO) {
+        char ruta[128], lista[4096];
+        snprintf(ruta, sizeof(ruta), "/sys/devices/system/node/node%d/cpulist", a->nodo);
+        FILE *f = fopen(ruta, "r");
+        if (f == NULL || fgets(lista, sizeof(lista), f) == NULL) {
+            fprintf(stderr, "Error: no se pudo leer las CPUs del nodo NUMA %d (%s).\n", a->nodo, ruta);
+            exit(EXIT_FAILURE);
+        }
+        fclose(f);
+        int cpus_nodo[CPU_SETSIZE];
+        int n = afinidad_parsear_lista(lista, cpus_nodo, CPU_SETSIZE);
+        cpu_set_t del_nodo;
+        CPU_ZERO(&del_nodo);
+        for (int i = 0; i < n; i++) {
+            if (CPU_ISSET(cpus_nodo[i], &permitidas)) CPU_SET(cpus_nodo[i], &del_nodo);
+        }
+        permitidas = del_nodo;
+    }
+
+    afinidad_ordenar(a, &permitidas, a->politica == AFINIDAD_DISPERSA);
+    if (a->n_cpus == 0) {
+        fprintf(stderr, "Error: la politica de afinidad no deja ninguna CPU disponible.\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Imprime el orden elegido ("0,1,2,3")
+static inline void afinidad_imprimir(const struct Afinidad *a) {
+    static const char *nombres[] = { "ninguna", "compacta", "dispersa", "lista", "nodo" };
+    if (a->politica == AFINIDAD_NINGUNA) return;
+    printf("Afinidad: %s (desde %d) -> CPUs ", nombres[a->politica], a->desde);
+    for (int i = 0; i < a->n_cpus; i++) printf(i ? ",%d" : "%d", a->cpus[i]);
+    printf("\n");
+}
+
+// Fija el hilo que llama (proceso hijo o pthread) a la CPU del trabajador 'indice'
+static inline int afinidad_aplicar(const struct Afinidad *a, int indice) {
+    if (a->politica == AFINIDAD_NINGUNA || a->n_cpus == 0) return -1;
+    int cpu = a->cpus[(a->desde + indice) % a->n_cpus];
+    cpu_set_t conjunto;
+    CPU_ZERO(&conjunto);
+    CPU_SET(cpu, &conjunto);
+    // pid 0 = el hilo que llama, asi sirve igual tras fork que dentro de un pthread
+    if (sched_setaffinity(0, sizeof(conjunto), &conjunto) == -1) {
+        perror("sched_setaffinity");
+        exit(EXIT_FAILURE);
+    }
+    return cpu;
+}
+
+// Liga el rango [direccion, direccion + tam) al nodo NUMA indicado. Se llama antes de
+// tocar las paginas del segmento: en memoria compartida la politica queda en el objeto,
+// asi que rige tambien para los mapeos de emisores y receptores.
+static inline int afinidad_ligar_memoria(void *direccion, size_t tam, int nodo) {
+    unsigned long mascara[16] = { 0 };
+    unsigned long bits = sizeof(mascara[0]) * 8;
+    if (nodo < 0 || (unsigned long)nodo >= bits * 16) {
+        errno = EINVAL;
+        return -1;
+    }
+    mascara[nodo / bits] |= 1UL << (nodo % bits);
+    return (int)syscall(SYS_mbind, direccion, tam, MPOL_BIND, mascara, bits * 16 + 1, MPOL_MF_MOVE);
+}
+
+#endif // AFINIDAD_H
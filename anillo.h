@@ -0,0 +1,88 @@
+#ifndef ANILLO_H
+#define ANILLO_H
+
+#include <stdatomic.h>
+#include "memInfo.h"
+#include "registro.h"
+
+// Anillo MPMC acotado sin locks (esquema de Vyukov) sobre el buffer compartido.
+// Cada celda tiene un numero de secuencia: vale 'pos' cuando esta libre para
+// el productor de la posicion 'pos', y 'pos + 1' cuando tiene un dato listo
+// para el consumidor de esa posicion. Productores y consumidores solo compiten
+// por un compare-and-swap sobre su propio contador de posicion.
+
+// Las secuencias viven justo despues de las celdas del buffer
+// (tam_registro es multiplo de 8, asi que quedan alineadas)
+static inline _Atomic unsigned long *anillo_secuencias(struct MemoriaCompartida *memoria) {
+    return (_Atomic unsigned long *)registro_celda(memoria, memoria->buffer_size);
+}
+
+// Bytes extra que necesita el segmento para las secuencias
+static inline size_t anillo_tam_extra(int buffer_size) {
+    return (size_t)buffer_size * sizeof(_Atomic unsigned long);
+}
+
+static inline void anillo_inicializar(struct MemoriaCompartida *memoria) {
+    _Atomic unsigned long *secuencias = anillo_secuencias(memoria);
+    for (int i = 0; i < memoria->buffer_size; i++) {
+        atomic_init(&secuencias[i], (unsigned long)i);
+    }
+    atomic_init(&memoria->productores.pos_encolar, 0);
+    atomic_init(&memoria->consumidores.pos_desencolar, 0);
+}
+
+// Inserta el item y completa item->indice con la celda usada.
+// Devuelve 0 si la celda que toca todavia no fue liberada por su consumidor.
+static inline int anillo_encolar(struct MemoriaCompartida *memoria, struct Bloque *item) {
+    _Atomic unsigned long *secuencias = anillo_secuencias(memoria);
+    unsigned long n = (unsigned long)memoria->buffer_size;
+    unsigned long pos = atomic_load_explicit(&memoria->productores.pos_encolar, memory_order_relaxed);
+
+    for (;;) {
+        unsigned long seq = atomic_load_explicit(&secuencias[pos % n], memory_order_acquire);
+        long diferencia = (long)seq - (long)pos;
+        if (diferencia == 0) {
+            if (atomic_compare_exchange_weak_explicit(&memoria->productores.pos_encolar, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diferencia < 0) {
+            return 0;
+        } else {
+            pos = atomic_load_explicit(&memoria->productores.pos_encolar, memory_order_relaxed);
+        }
+    }
+
+    item->indice = (int)(pos % n);
+    registro_escribir(memoria, (int)(pos % n), item);
+    atomic_store_explicit(&secuencias[pos % n], pos + 1, memory_order_release);
+    return 1;
+}
+
+// Extrae el proximo item. Devuelve 0 si la celda que toca aun no fue publicada.
+static inline int anillo_desencolar(struct MemoriaCompartida *memoria, struct Bloque *item) {
+    _Atomic unsigned long *secuencias = anillo_secuencias(memoria);
+    unsigned long n = (unsigned long)memoria->buffer_size;
+    unsigned long pos = atomic_load_explicit(&memoria->consumidores.pos_desencolar, memory_order_relaxed);
+
+    for (;;) {
+        unsigned long seq = atomic_load_explicit(&secuencias[pos % n], memory_order_acquire);
+        long diferencia = (long)seq - (long)(pos + 1);
+        if (diferencia == 0) {
+            if (atomic_compare_exchange_weak_explicit(&memoria->consumidores.pos_desencolar, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diferencia < 0) {
+            return 0;
+        } else {
+            pos = atomic_load_explicit(&memoria->consumidores.pos_desencolar, memory_order_relaxed);
+        }
+    }
+
+    registro_leer(memoria, (int)(pos % n), item);
+    atomic_store_explicit(&secuencias[pos % n], pos + n, memory_order_release);
+    return 1;
+}
+
+#endif // ANILLO_H
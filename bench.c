@@ -0,0 +1,395 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <dirent.h>         // Para limpiar el directorio de bitacoras
+#include <time.h>           // Para clock_gettime, nanosleep
+#include <sys/mman.h>       // Para shm_open, mmap
+#include <sys/stat.h>
+#include <sys/wait.h>       // Para waitpid
+#include <sys/resource.h>   // Para getrusage
+#include "memInfo.h"
+#include "segmento.h"
+#include "cifrado.h"        // Kernels de cifrado para --cifrado
+
+// Benchmark de extremo a extremo: genera una entrada sintetica y, para cada combinacion
+// buffer x emisores x receptores, levanta el pipeline completo sin interaccion
+// (inicializador -> receptor -> emisor -> finalizador --inmediato) y emite una fila CSV.
+// Emisores y receptores corren en modo silencioso (--bitacora) para no medir la terminal.
+// Con --cifrado solo mide los kernels de cifrado (XOR y ChaCha20, escalar y vectorizado).
+
+#define BENCH_MAX_VALORES   16
+#define BENCH_MAX_ARGS      64
+#define BENCH_LLAVE         "42"
+#define BENCH_LARGO_LINEA   80      // Caracteres por linea de la entrada sintetica
+#define BENCH_CIFRADO_S     0.5     // Tiempo minimo de cada medicion de --cifrado
+#define BENCH_SALIDA        "files/output.txt"  // Archivo que escribe el receptor
+
+void reportar_error_y_salir(const char *msg) {
+    perror(msg);
+    exit(EXIT_FAILURE);
+}
+
+void imprimir_uso_y_salir(const char *programa) {
+    fprintf(stderr, "Uso: %s [--tam <bytes>] [--buffers a,b,..] [--emisores a,b,..] [--receptores a,b,..]\n"
+                    "          [--init \"<opciones>\"] [--opc-emisor \"<opciones>\"] [--opc-receptor \"<opciones>\"]\n"
+                    "          [--bin <dir>] [--timeout <segundos>]\n"
+                    "       %s --cifrado [--tam <bytes>] [--unidad <bytes>]\n", programa, programa);
+    exit(EXIT_FAILURE);
+}
+
+static double reloj_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Convierte "1,2,4" en un arreglo de enteros positivos; devuelve cuantos hay
+static int parsear_lista(const char *texto, int *valores) {
+    char copia[256];
+    snprintf(copia, sizeof(copia), "%s", texto);
+    int n = 0;
+    for (char *tok = strtok(copia, ","); tok != NULL && n < BENCH_MAX_VALORES; tok = strtok(NULL, ",")) {
+        valores[n] = atoi(tok);
+        if (valores[n] <= 0) return 0;
+        n++;
+    }
+    return n;
+}
+
+// Agrega al argv las opciones extra separadas por espacios (la cadena se modifica)
+static int agregar_opciones(char **args, int n, char *opciones) {
+    if (opciones == NULL) return n;
+    for (char *tok = strtok(opciones, " "); tok != NULL && n < BENCH_MAX_ARGS - 1; tok = strtok(NULL, " ")) {
+        args[n++] = tok;
+    }
+    return n;
+}
+
+// Lanza un programa con su salida estandar descartada; stderr se conserva para ver errores
+static pid_t lanzar(char **args) {
+    pid_t pid = fork();
+    if (pid < 0) reportar_error_y_salir("fork");
+    if (pid == 0) {
+        int nulo = open("/dev/null", O_WRONLY);
+        if (nulo != -1) {
+            dup2(nulo, STDOUT_FILENO);
+            close(nulo);
+        }
+        execv(args[0], args);
+        perror(args[0]);
+        _exit(127);
+    }
+    return pid;
+}
+
+static int esperar(pid_t pid) {
+    int estado;
+    while (waitpid(pid, &estado, 0) == -1) {
+        if (errno != EINTR) reportar_error_y_salir("waitpid");
+    }
+    return WIFEXITED(estado) && WEXITSTATUS(estado) == 0 ? 0 : -1;
+}
+
+// Entrada sintetica: texto imprimible en lineas de BENCH_LARGO_LINEA caracteres.
+// Devuelve la cantidad de bytes sin saltos de linea (lo que transporta ORDEN_LLEGADA).
+static long generar_entrada(const char *ruta, long tam) {
+    FILE *archivo = fopen(ruta, "w");
+    if (archivo == NULL) reportar_error_y_salir("fopen (entrada sintetica)");
+    unsigned int semilla = 12345;
+    long utiles = 0;
+    for (long i = 0; i < tam; i++) {
+        if (i % (BENCH_LARGO_LINEA + 1) == BENCH_LARGO_LINEA) {
+            fputc('\n', archivo);
+        } else {
+            semilla = semilla * 1103515245u + 12345u;
+            fputc(' ' + (semilla >> 16) % 95, archivo);
+            utiles++;
+        }
+    }
+    if (fclose(archivo) != 0) reportar_error_y_salir("fclose (entrada sintetica)");
+    return utiles;
+}
+
+// Compara la salida del receptor con la entrada: identica en ORDEN_FUENTE; en orden de
+// llegada las unidades pueden quedar en cualquier orden, asi que se compara la cantidad
+// de cada byte (sin los saltos de linea, que no se transportan). 0 si coincide.
+static int verificar_salida(const char *entrada, const char *salida, int orden_fuente) {
+    FILE *a = fopen(entrada, "r"), *b = fopen(salida, "r");
+    int distinta = a == NULL || b == NULL;
+    if (!distinta && orden_fuente) {
+        int ca, cb;
+        do {
+            ca = getc(a);
+            cb = getc(b);
+        } while (ca == cb && ca != EOF);
+        distinta = ca != cb;
+    } else if (!distinta) {
+        long cuentas[256] = { 0 };
+        int c;
+        while ((c = getc(a)) != EOF) if (c != '\n') cuentas[c]++;
+        while ((c = getc(b)) != EOF) cuentas[c]--;
+        for (int i = 0; i < 256; i++) distinta |= cuentas[i] != 0;
+    }
+    if (a != NULL) fclose(a);
+    if (b != NULL) fclose(b);
+    return distinta ? -1 : 0;
+}
+
+static void vaciar_directorio(const char *ruta) {
+    DIR *dir = opendir(ruta);
+    if (dir == NULL) return;
+    struct dirent *entrada;
+    char archivo[512];
+    while ((entrada = readdir(dir)) != NULL) {
+        if (entrada->d_name[0] == '.') continue;
+        snprintf(archivo, sizeof(archivo), "%s/%s", ruta, entrada->d_name);
+        unlink(archivo);
+    }
+    closedir(dir);
+}
+
+struct ConfigBench {
+    const char *dir_bin;
+    const char *entrada;
+    char dir_bitacora[64];
+    const char *opc_init;
+    const char *opc_emisor;
+    const char *opc_receptor;
+    long tam_entrada;               // Bytes de la entrada (lo que transporta ORDEN_FUENTE)
+    long utiles;                    // Bytes sin saltos de linea (lo que transporta ORDEN_LLEGADA)
+    double timeout_s;
+};
+
+// Ejecuta una combinacion completa e imprime su fila CSV
+static void correr_configuracion(const struct ConfigBench *cfg, int buffer, int emisores, int receptores) {
+    char shm_name[64], ruta[5][512], str_buffer[16], str_emisores[16], str_receptores[16];
+    char extras[3][256];
+    char *args[BENCH_MAX_ARGS];
+    int n;
+
+    snprintf(shm_name, sizeof(shm_name), "/bench_%d", getpid());
+    snprintf(str_buffer, sizeof(str_buffer), "%d", buffer);
+    snprintf(str_emisores, sizeof(str_emisores), "%d", emisores);
+    snprintf(str_receptores, sizeof(str_receptores), "%d", receptores);
+    snprintf(ruta[0], sizeof(ruta[0]), "%s/inicializador", cfg->dir_bin);
+    snprintf(ruta[1], sizeof(ruta[1]), "%s/receptor", cfg->dir_bin);
+    snprintf(ruta[2], sizeof(ruta[2]), "%s/emisor", cfg->dir_bin);
+    snprintf(ruta[3], sizeof(ruta[3]), "%s/finalizador", cfg->dir_bin);
+    snprintf(ruta[4], sizeof(ruta[4]), "%s/lector", cfg->dir_bin);
+    snprintf(extras[0], sizeof(extras[0]), "%s", cfg->opc_init ? cfg->opc_init : "");
+    snprintf(extras[1], sizeof(extras[1]), "%s", cfg->opc_receptor ? cfg->opc_receptor : "");
+    snprintf(extras[2], sizeof(extras[2]), "%s", cfg->opc_emisor ? cfg->opc_emisor : "");
+
+    // --- 1. Inicializador sin preguntas ---
+    n = 0;
+    args[n++] = ruta[0];
+    args[n++] = "--id";     args[n++] = shm_name;
+    args[n++] = "--buffer"; args[n++] = str_buffer;
+    args[n++] = "--llave";  args[n++] = BENCH_LLAVE;
+    args[n++] = "--fuente"; args[n++] = (char *)cfg->entrada;
+    n = agregar_opciones(args, n, extras[0]);
+    args[n] = NULL;
+    if (esperar(lanzar(args)) == -1) {
+        fprintf(stderr, "bench: fallo el inicializador (buffer=%d)\n", buffer);
+        exit(EXIT_FAILURE);
+    }
+
+    int shm_fd = segmento_abrir(shm_name, O_RDONLY);
+    if (shm_fd == -1) reportar_error_y_salir("shm_open (bench)");
+    const struct MemoriaCompartida *memoria = mmap(NULL, sizeof(struct MemoriaCompartida), PROT_READ, MAP_SHARED, shm_fd, 0);
+    if (memoria == MAP_FAILED) reportar_error_y_salir("mmap (bench)");
+
+    struct rusage uso_antes, uso_despues;
+    getrusage(RUSAGE_CHILDREN, &uso_antes);
+    double inicio = reloj_s();
+
+    // --- 2. Lector (solo con --lectura flujo), receptores y emisores en modo silencioso ---
+    pid_t pid_lector = -1;
+    if (memoria->modo_lectura == LECTURA_FLUJO) {
+        n = 0;
+        args[n++] = ruta[4]; args[n++] = shm_name;
+        args[n] = NULL;
+        pid_lector = lanzar(args);
+    }
+
+    n = 0;
+    args[n++] = ruta[1]; args[n++] = shm_name; args[n++] = "automatico"; args[n++] = str_receptores;
+    args[n++] = "--bitacora"; args[n++] = (char *)cfg->dir_bitacora;
+    n = agregar_opciones(args, n, extras[1]);
+    args[n] = NULL;
+    pid_t pid_receptor = lanzar(args);
+
+    n = 0;
+    args[n++] = ruta[2]; args[n++] = shm_name; args[n++] = "automatico"; args[n++] = str_emisores;
+    args[n++] = "--bitacora"; args[n++] = (char *)cfg->dir_bitacora;
+    n = agregar_opciones(args, n, extras[2]);
+    args[n] = NULL;
+    pid_t pid_emisor = lanzar(args);
+
+    // --- 3. Esperar a que todo lo producible se haya consumido ---
+    // En orden de fuente los saltos de linea tambien viajan: se espera el archivo entero
+    int orden_fuente = memoria->orden_salida == ORDEN_FUENTE;
+    long esperados = orden_fuente ? cfg->tam_entrada : cfg->utiles;
+    struct timespec pausa = { 0, 1000000 };     // 1 ms entre muestras
+    int completo = 1;
+    while (atomic_load(&memoria->consumidores.total_consumidos) < esperados) {
+        if (reloj_s() - inicio > cfg->timeout_s) {
+            completo = 0;
+            break;
+        }
+        nanosleep(&pausa, NULL);
+    }
+    double fin = reloj_s();
+
+    // --- 4. Cierre elegante con el finalizador real ---
+    n = 0;
+    args[n++] = ruta[3]; args[n++] = shm_name; args[n++] = "--inmediato";
+    args[n] = NULL;
+    int ok = esperar(lanzar(args));
+    ok |= esperar(pid_emisor);
+    ok |= esperar(pid_receptor);
+    if (pid_lector != -1) ok |= esperar(pid_lector);
+    getrusage(RUSAGE_CHILDREN, &uso_despues);
+
+    long consumidos = atomic_load(&memoria->consumidores.total_consumidos);
+    munmap((void *)memoria, sizeof(struct MemoriaCompartida));
+    close(shm_fd);
+    vaciar_directorio(cfg->dir_bitacora);
+
+    double pared = fin - inicio;
+    double cpu_usuario = (uso_despues.ru_utime.tv_sec - uso_antes.ru_utime.tv_sec)
+                       + (uso_despues.ru_utime.tv_usec - uso_antes.ru_utime.tv_usec) / 1e6;
+    double cpu_sistema = (uso_despues.ru_stime.tv_sec - uso_antes.ru_stime.tv_sec)
+                       + (uso_despues.ru_stime.tv_usec - uso_antes.ru_stime.tv_usec) / 1e6;
+    // Una configuracion que pierde o corrompe datos no puede reportar un numero rapido
+    int valida = completo && ok == 0 && verificar_salida(cfg->entrada, BENCH_SALIDA, orden_fuente) == 0;
+    const char *estado = !completo ? "timeout" : ok != 0 ? "error" : !valida ? "invalido" : "ok";
+
+    printf("%d,%d,%d,%ld,%.6f,%.6f,%.6f,%.0f,%s\n", buffer, emisores, receptores, consumidos,
+           pared, cpu_usuario, cpu_sistema, pared > 0 ? consumidos / pared : 0.0, estado);
+    fflush(stdout);
+}
+
+// Cifra 'tam' bytes en unidades de 'unidad' bytes, como lo hacen emisores y receptores,
+// hasta juntar BENCH_CIFRADO_S segundos. Emite una fila CSV por algoritmo y kernel.
+static void medir_cifrado(long tam, int unidad) {
+    unsigned char *datos = malloc(tam);
+    if (datos == NULL) reportar_error_y_salir("malloc (cifrado)");
+    for (long i = 0; i < tam; i++) datos[i] = (unsigned char)(i * 31 + 7);
+
+    static struct MemoriaCompartida memoria;
+    memoria.llave_desencriptar = 42;
+    for (int i = 0; i < 8; i++) memoria.clave_chacha[i] = 0x9e3779b9u * (i + 1);
+    memoria.nonce_chacha = 0x0123456789abcdefULL;
+
+    cifrado_preparar();
+    struct { int algoritmo; const char *kernel; FuncionXor xor; FuncionChacha chacha; } casos[] = {
+        { CIFRADO_XOR,      "escalar",     xor_escalar, NULL },
+        { CIFRADO_XOR,      xor_nombre,    xor_funcion, NULL },
+        { CIFRADO_CHACHA20, "escalar",     NULL, chacha_escalar },
+        { CIFRADO_CHACHA20, chacha_nombre, NULL, chacha_funcion },
+    };
+    printf("cifrado,kernel,unidad,bytes,segundos,bytes_por_s\n");
+    for (size_t c = 0; c < sizeof(casos) / sizeof(casos[0]); c++) {
+        memoria.algoritmo_cifrado = casos[c].algoritmo;
+        xor_funcion = casos[c].xor != NULL ? casos[c].xor : xor_funcion;
+        chacha_funcion = casos[c].chacha != NULL ? casos[c].chacha : chacha_funcion;
+
+        struct Bloque item;
+        item.trabajo = 0;
+        long procesados = 0;
+        double inicio = reloj_s(), transcurrido;
+        do {
+            for (long offset = 0; offset < tam; offset += unidad) {
+                item.offset_fuente = offset;
+                item.datos = datos + offset;
+                item.longitud = (int)(tam - offset < unidad ? tam - offset : unidad);
+                cifrado_aplicar(&memoria, &item);
+            }
+            procesados += tam;
+            transcurrido = reloj_s() - inicio;
+        } while (transcurrido < BENCH_CIFRADO_S);
+
+        printf("%s,%s,%d,%ld,%.6f,%.0f\n", cifrado_nombre(casos[c].algoritmo), casos[c].kernel, unidad,
+               procesados, transcurrido, procesados / transcurrido);
+        fflush(stdout);
+    }
+    free(datos);
+}
+
+int main(int argc, char *argv[]) {
+    long tam = 1 << 20;
+    int buffers[BENCH_MAX_VALORES] = { 16, 256, 4096 }, n_buffers = 3;
+    int emisores[BENCH_MAX_VALORES] = { 1, 2, 4 }, n_emisores = 3;
+    int receptores[BENCH_MAX_VALORES] = { 1, 2, 4 }, n_receptores = 3;
+    struct ConfigBench cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.dir_bin = "build";
+    cfg.timeout_s = 120;
+    int solo_cifrado = 0;
+    int unidad = TAM_BLOQUE_DEFECTO;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--tam") == 0 && i + 1 < argc) {
+            tam = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--buffers") == 0 && i + 1 < argc) {
+            n_buffers = parsear_lista(argv[++i], buffers);
+        } else if (strcmp(argv[i], "--emisores") == 0 && i + 1 < argc) {
+            n_emisores = parsear_lista(argv[++i], emisores);
+        } else if (strcmp(argv[i], "--receptores") == 0 && i + 1 < argc) {
+            n_receptores = parsear_lista(argv[++i], receptores);
+        } else if (strcmp(argv[i], "--init") == 0 && i + 1 < argc) {
+            cfg.opc_init = argv[++i];
+        } else if (strcmp(argv[i], "--opc-emisor") == 0 && i + 1 < argc) {
+            cfg.opc_emisor = argv[++i];
+        } else if (strcmp(argv[i], "--opc-receptor") == 0 && i + 1 < argc) {
+            cfg.opc_receptor = argv[++i];
+        } else if (strcmp(argv[i], "--bin") == 0 && i + 1 < argc) {
+            cfg.dir_bin = argv[++i];
+        } else if (strcmp(argv[i], "--timeout") == 0 && i + 1 < argc) {
+            cfg.timeout_s = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--cifrado") == 0) {
+            solo_cifrado = 1;
+        } else if (strcmp(argv[i], "--unidad") == 0 && i + 1 < argc) {
+            unidad = atoi(argv[++i]);
+        } else {
+            imprimir_uso_y_salir(argv[0]);
+        }
+    }
+    if (tam <= 0 || n_buffers == 0 || n_emisores == 0 || n_receptores == 0 || cfg.timeout_s <= 0) {
+        imprimir_uso_y_salir(argv[0]);
+    }
+    if (solo_cifrado) {
+        if (unidad <= 0) imprimir_uso_y_salir(argv[0]);
+        medir_cifrado(tam, unidad);
+        return EXIT_SUCCESS;
+    }
+
+    // Entrada sintetica y directorio de bitacoras temporales
+    snprintf(cfg.dir_bitacora, sizeof(cfg.dir_bitacora), "/tmp/bench_%d", getpid());
+    if (mkdir(cfg.dir_bitacora, 0777) == -1) reportar_error_y_salir("mkdir (bitacoras)");
+    char entrada[128];
+    snprintf(entrada, sizeof(entrada), "/tmp/bench_%d_entrada.txt", getpid());
+    cfg.utiles = generar_entrada(entrada, tam);
+    cfg.tam_entrada = tam;
+    cfg.entrada = entrada;
+
+    fprintf(stderr, "bench: %ld bytes de entrada (%ld sin saltos de linea), %d configuraciones\n",
+            tam, cfg.utiles, n_buffers * n_emisores * n_receptores);
+
+    printf("buffer,emisores,receptores,bytes,pared_s,cpu_usuario_s,cpu_sistema_s,bytes_por_s,estado\n");
+    for (int b = 0; b < n_buffers; b++) {
+        for (int e = 0; e < n_emisores; e++) {
+            for (int r = 0; r < n_receptores; r++) {
+                correr_configuracion(&cfg, buffers[b], emisores[e], receptores[r]);
+            }
+        }
+    }
+
+    unlink(cfg.entrada);
+    rmdir(cfg.dir_bitacora);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+#ifndef BITACORA_H
+#define BITACORA_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>    // Para SYS_gettid
+
+// Bitacora binaria de eventos para el modo silencioso de emisores y receptores.
+// En lugar de imprimir cada caracter, cada proceso acumula eventos de tamano
+// fijo en un anillo local y lo vuelca con un solo write() cuando se llena.
+// El programa logdump reconstruye despues la misma tabla con colores.
+//
+// Archivo: <dir>/<emisor|receptor>_<tid>.bin = CabeceraBitacora + EventoBitacora[]
+// (el TID es el PID para los trabajadores que son procesos)
+
+#define BITACORA_MAGIA   "BITACOR1"
+#define BITACORA_EVENTOS 4096           // Eventos en el anillo local antes de volcar
+
+#define EVENTO_EMISOR    0
+#define EVENTO_RECEPTOR  1
+
+// Definida en cada programa
+void reportar_error_y_salir(const char *msg);
+
+struct CabeceraBitacora {
+    char magia[8];
+    int32_t pid;
+    int32_t tipo;                   // EVENTO_EMISOR o EVENTO_RECEPTOR
+    int64_t base_monotonica_ns;     // CLOCK_MONOTONIC al abrir la bitacora
+    int64_t base_real_ns;           // CLOCK_REALTIME en el mismo instante
+};
+
+struct EventoBitacora {
+    int64_t t_ns;                   // CLOCK_MONOTONIC del evento
+    int64_t offset_fuente;          // Offset en la fuente (-1 si el formato no lo guarda)
+    int32_t indice;                 // Celda del buffer
+    uint32_t longitud;              // Bytes de la unidad (1 o la longitud del bloque)
+    uint8_t cifrado;                // Primer byte cifrado
+    uint8_t original;               // Primer byte original
+    uint8_t reservado[6];
+};
+
+struct Bitacora {
+    int fd;
+    int cantidad;
+    struct EventoBitacora eventos[BITACORA_EVENTOS];
+};
+
+static inline int64_t bitacora_reloj_ns(clockid_t reloj) {
+    struct timespec ts;
+    clock_gettime(reloj, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static inline void bitacora_abrir(struct Bitacora *bitacora, const char *directorio, int tipo) {
+    char ruta[512];
+    int tid = (int)syscall(SYS_gettid);
+    int r = snprintf(ruta, sizeof(ruta), "%s/%s_%d.bin", directorio,
+                     tipo == EVENTO_EMISOR ? "emisor" : "receptor", tid);
+    if (r < 0 || (size_t)r >= sizeof(ruta)) reportar_error_y_salir("bitacora: ruta truncada");
+
+    bitacora->fd = open(ruta, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (bitacora->fd == -1) reportar_error_y_salir("open (bitacora)");
+    bitacora->cantidad = 0;
+
+    struct CabeceraBitacora cabecera;
+    memset(&cabecera, 0, sizeof(cabecera));
+    memcpy(cabecera.magia, BITACORA_MAGIA, sizeof(cabecera.magia));
+    cabecera.pid = tid;
+    cabecera.tipo = tipo;
+    cabecera.base_monotonica_ns = bitacora_reloj_ns(CLOCK_MONOTONIC);
+    cabecera.base_real_ns = bitacora_reloj_ns(CLOCK_REALTIME);
+    if (write(bitacora->fd, &cabecera, sizeof(cabecera)) != (ssize_t)sizeof(cabecera)) {
+        reportar_error_y_salir("write (bitacora)");
+    }
+}
+
+static inline void bitacora_volcar(struct Bitacora *bitacora) {
+    const char *datos = (const char *)bitacora->eventos;
+    size_t pendiente = (size_t)bitacora->cantidad * sizeof(struct EventoBitacora);
+    while (pendiente > 0) {
+        ssize_t n = write(bitacora->fd, datos, pendiente);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            reportar_error_y_salir("write (bitacora)");
+        }
+        datos += n;
+        pendiente -= n;
+    }
+    bitacora->cantidad = 0;
+}
+
+static inline void bitacora_registrar(struct Bitacora *bitacora, long offset_fuente, int indice,
+                                      int longitud, unsigned char cifrado, unsigned char original) {
+    struct EventoBitacora *evento = &bitacora->eventos[bitacora->cantidad];
+    evento->t_ns = bitacora_reloj_ns(CLOCK_MONOTONIC);
+    evento->offset_fuente = offset_fuente;
+    evento->indice = indice;
+    evento->longitud = (uint32_t)longitud;
+    evento->cifrado = cifrado;
+    evento->original = original;
+    memset(evento->reservado, 0, sizeof(evento->reservado));
+    if (++bitacora->cantidad == BITACORA_EVENTOS) bitacora_volcar(bitacora);
+}
+
+static inline void bitacora_cerrar(struct Bitacora *bitacora) {
+    bitacora_volcar(bitacora);
+    close(bitacora->fd);
+}
+
+#endif // BITACORA_H
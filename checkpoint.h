@@ -0,0 +1,242 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>          // Para O_CREAT, O_RDWR
+#include <unistd.h>         // Para ftruncate, close
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "memInfo.h"
+#include "sincronizacion.h"
+#include "metricas.h"
+
+// Puntos de control (--checkpoint <archivo>): los receptores cuentan cuantos bytes
+// de cada granulo de la fuente ya llegaron al archivo de salida, y la marca de agua
+// baja (el prefijo de la fuente escrito entero) se guarda de forma periodica en un
+// archivo lateral de texto. Con --reanudar el inicializador recorta la salida a esa
+// marca y la corrida arranca desde ahi. Requiere ORDEN_FUENTE: es el unico orden en
+// que la posicion en la salida es la posicion en la fuente.
+//
+// El estado compartido vive en el segmento aparte <shm_id>_checkpoint: una cabecera
+// struct Checkpoint y un contador por granulo. Un rango cuenta cuando sus bytes ya
+// estan en el kernel (pwrite o io_uring completado, memcpy al mapeo), asi que una
+// caida de cualquier trabajador nunca deja la marca por delante de lo escrito.
+// El archivo se reemplaza con rename: no sobrevive a una caida del sistema (no hay fsync).
+
+#define CHECKPOINT_GRANULO_DEFECTO (1024 * 1024)    // Resolucion de la marca (bytes)
+#define CHECKPOINT_CADA_DEFECTO    1000             // Intervalo entre guardados (ms)
+#define CHECKPOINT_MAX_GRANULOS    (1 << 20)        // Con fuentes enormes crece el granulo
+
+struct Checkpoint {
+    // --- Configuracion (la escribe el inicializador) ---
+    char ruta[256];                 // Archivo lateral
+    char fuente[256];
+    char salida[256];               // La anota el lanzador de receptores ("" = aun no se sabe)
+    long tam_fuente;
+    long mtime_fuente;              // Para detectar una fuente modificada al reanudar
+    long granulo;
+    long num_granulos;
+    long intervalo_ns;
+    long reanudado_desde;           // Marca con la que arranco la corrida
+
+    _Alignas(TAM_LINEA_CACHE) _Atomic long granulos_completos;  // Marca de agua baja, en granulos
+    _Atomic long ultimo_guardado_ns;
+    _Atomic long guardados;         // Veces que se escribio el archivo lateral
+
+    _Alignas(TAM_LINEA_CACHE) _Atomic long escritos[];  // Bytes ya escritos de cada granulo
+};
+
+// Contenido del archivo lateral
+struct ArchivoCheckpoint {
+    char fuente[256];
+    char salida[256];
+    long tam_fuente;
+    long mtime_fuente;
+    long escrito;                   // Bytes de la fuente ya escritos enteros en la salida
+};
+
+static inline size_t checkpoint_tam_segmento(long num_granulos) {
+    return sizeof(struct Checkpoint) + (size_t)num_granulos * sizeof(_Atomic long);
+}
+
+static inline void checkpoint_nombre(char *destino, size_t tam, const char *shm_name) {
+    sincronizacion_nombre(destino, tam, shm_name, SHM_CHECKPOINT_NAME_SUFFIX);
+}
+
+static inline long checkpoint_tam_granulo(const struct Checkpoint *cp, long g) {
+    long resto = cp->tam_fuente - g * cp->granulo;
+    return resto < cp->granulo ? resto : cp->granulo;
+}
+
+// Bytes de la fuente escritos enteros desde el principio
+static inline long checkpoint_escrito(const struct Checkpoint *cp) {
+    long escrito = atomic_load(&cp->granulos_completos) * cp->granulo;
+    return escrito < cp->tam_fuente ? escrito : cp->tam_fuente;
+}
+
+// --- Archivo lateral ---
+
+// Lee el archivo lateral. Devuelve 0, 1 si no existe o -1 si es invalido.
+static inline int checkpoint_archivo_leer(const char *ruta, struct ArchivoCheckpoint *destino) {
+    FILE *archivo = fopen(ruta, "r");
+    if (archivo == NULL) {
+        if (errno == ENOENT) return 1;
+        fprintf(stderr, "Error al abrir el checkpoint: %s\n", ruta);
+        return -1;
+    }
+    memset(destino, 0, sizeof(*destino));
+    destino->tam_fuente = destino->escrito = -1;
+    // Una linea "<clave> <valor>" por campo; las rutas van hasta el fin de la linea
+    char linea[600];
+    while (fgets(linea, sizeof(linea), archivo) != NULL) {
+        linea[strcspn(linea, "\n")] = '\0';
+        char *valor = strchr(linea, ' ');
+        if (linea[0] == '#' || valor == NULL) continue;
+        *valor++ = '\0';
+        if (strcmp(linea, "fuente") == 0) snprintf(destino->fuente, sizeof(destino->fuente), "%s", valor);
+        else if (strcmp(linea, "salida") == 0) snprintf(destino->salida, sizeof(destino->salida), "%s", valor);
+        else if (strcmp(linea, "tam") == 0) destino->tam_fuente = atol(valor);
+        else if (strcmp(linea, "mtime") == 0) destino->mtime_fuente = atol(valor);
+        else if (strcmp(linea, "escrito") == 0) destino->escrito = atol(valor);
+    }
+    fclose(archivo);
+    if (destino->fuente[0] == '\0' || destino->tam_fuente < 0 || destino->escrito < 0 ||
+        destino->escrito > destino->tam_fuente || (destino->escrito > 0 && destino->salida[0] == '\0')) {
+        fprintf(stderr, "El checkpoint %s esta incompleto o es invalido.\n", ruta);
+        return -1;
+    }
+    return 0;
+}
+
+// Escribe el archivo lateral con la marca actual: primero en un temporal propio y
+// luego rename, asi un lector nunca ve un archivo a medias. Si dos guardados se
+// cruzan puede quedar el de la marca menor, que sigue siendo valido.
+static inline int checkpoint_guardar(struct Checkpoint *cp) {
+    char temporal[300];
+    snprintf(temporal, sizeof(temporal), "%s.%d.tmp", cp->ruta, id_trabajador());
+    FILE *archivo = fopen(temporal, "w");
+    if (archivo == NULL) {
+        fprintf(stderr, "Aviso: no se pudo escribir el checkpoint %s: %s\n", temporal, strerror(errno));
+        return -1;
+    }
+    fprintf(archivo, "# Checkpoint: bytes de la fuente ya escritos enteros en la salida\n");
+    fprintf(archivo, "fuente %s\n", cp->fuente);
+    fprintf(archivo, "tam %ld\n", cp->tam_fuente);
+    fprintf(archivo, "mtime %ld\n", cp->mtime_fuente);
+    if (cp->salida[0] != '\0') fprintf(archivo, "salida %s\n", cp->salida);
+    fprintf(archivo, "escrito %ld\n", checkpoint_escrito(cp));
+    if (fclose(archivo) != 0 || rename(temporal, cp->ruta) == -1) {
+        fprintf(stderr, "Aviso: no se pudo escribir el checkpoint %s: %s\n", cp->ruta, strerror(errno));
+        unlink(temporal);
+        return -1;
+    }
+    atomic_fetch_add(&cp->guardados, 1);
+    return 0;
+}
+
+// --- Segmento compartido ---
+
+// Avanza la marca sobre los granulos completos. Devuelve 1 si la movio.
+static inline int checkpoint_avanzar(struct Checkpoint *cp) {
+    int avanzo = 0;
+    for (;;) {
+        long g = atomic_load(&cp->granulos_completos);
+        if (g >= cp->num_granulos || atomic_load(&cp->escritos[g]) < checkpoint_tam_granulo(cp, g)) return avanzo;
+        if (atomic_compare_exchange_weak(&cp->granulos_completos, &g, g + 1)) avanzo = 1;
+    }
+}
+
+// Inicializador: crea el segmento con la marca en 'desde'. Devuelve el segmento mapeado (tamano en *tam).
+static inline struct Checkpoint *checkpoint_crear(const char *shm_name, const char *ruta, const char *fuente,
+                                                  const struct stat *info, long desde, long granulo,
+                                                  long intervalo_ms, size_t *tam) {
+    long tam_fuente = info->st_size;
+    if ((tam_fuente + granulo - 1) / granulo > CHECKPOINT_MAX_GRANULOS) {
+        granulo = (tam_fuente + CHECKPOINT_MAX_GRANULOS - 1) / CHECKPOINT_MAX_GRANULOS;
+    }
+    long num_granulos = (tam_fuente + granulo - 1) / granulo;
+
+    char nombre[512];
+    checkpoint_nombre(nombre, sizeof(nombre), shm_name);
+    int fd = shm_open(nombre, O_CREAT | O_RDWR, 0666);
+    if (fd == -1) reportar_error_y_salir("shm_open (checkpoint)");
+    *tam = checkpoint_tam_segmento(num_granulos);
+    if (ftruncate(fd, *tam) == -1) reportar_error_y_salir("ftruncate (checkpoint)");
+    struct Checkpoint *cp = mmap(NULL, *tam, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (cp == MAP_FAILED) reportar_error_y_salir("mmap (checkpoint)");
+    close(fd);
+
+    snprintf(cp->ruta, sizeof(cp->ruta), "%s", ruta);
+    snprintf(cp->fuente, sizeof(cp->fuente), "%s", fuente);
+    cp->salida[0] = '\0';
+    cp->tam_fuente = tam_fuente;
+    cp->mtime_fuente = info->st_mtime;
+    cp->granulo = granulo;
+    cp->num_granulos = num_granulos;
+    cp->intervalo_ns = intervalo_ms * 1000000L;
+    cp->reanudado_desde = desde;
+    atomic_init(&cp->ultimo_guardado_ns, metricas_ahora_ns());
+    atomic_init(&cp->guardados, 0);
+    // Lo anterior a 'desde' ya esta escrito (la marca de otro granulo puede no caer en un borde)
+    atomic_init(&cp->granulos_completos, desde / granulo);
+    for (long g = 0; g < num_granulos; g++) atomic_init(&cp->escritos[g], 0);
+    if (desde / granulo < num_granulos) atomic_init(&cp->escritos[desde / granulo], desde % granulo);
+    checkpoint_avanzar(cp);
+    return cp;
+}
+
+static inline struct Checkpoint *checkpoint_abrir(const char *shm_name, size_t *tam) {
+    char nombre[512];
+    checkpoint_nombre(nombre, sizeof(nombre), shm_name);
+    int fd = shm_open(nombre, O_RDWR, 0666);
+    if (fd == -1) reportar_error_y_salir("shm_open (checkpoint)");
+    struct stat info;
+    if (fstat(fd, &info) == -1) reportar_error_y_salir("fstat (checkpoint)");
+    *tam = info.st_size;
+    struct Checkpoint *cp = mmap(NULL, *tam, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (cp == MAP_FAILED) reportar_error_y_salir("mmap (checkpoint)");
+    close(fd);
+    return cp;
+}
+
+static inline void checkpoint_cerrar(struct Checkpoint *cp, size_t tam) {
+    munmap(cp, tam);
+}
+
+// Borra el segmento (no falla si no existe)
+static inline void checkpoint_eliminar(const char *shm_name) {
+    char nombre[512];
+    checkpoint_nombre(nombre, sizeof(nombre), shm_name);
+    shm_unlink(nombre);
+}
+
+// --- Lado de los receptores ---
+
+// Los bytes [inicio, inicio + len) de la fuente ya estan en el archivo de salida.
+// Quien completa un granulo intenta avanzar la marca; si paso el intervalo (o la
+// fuente quedo completa) un CAS sobre ultimo_guardado_ns elige a uno solo para guardar.
+static inline void checkpoint_registrar(struct Checkpoint *cp, long inicio, long len) {
+    if (cp == NULL || len <= 0) return;
+    int completo = 0;
+    while (len > 0) {
+        long g = inicio / cp->granulo;
+        long parte = (g + 1) * cp->granulo - inicio;
+        if (parte > len) parte = len;
+        if (atomic_fetch_add(&cp->escritos[g], parte) + parte == checkpoint_tam_granulo(cp, g)) completo = 1;
+        inicio += parte;
+        len -= parte;
+    }
+    if (!completo || !checkpoint_avanzar(cp)) return;
+
+    long ahora = metricas_ahora_ns();
+    long ultimo = atomic_load(&cp->ultimo_guardado_ns);
+    int fin = atomic_load(&cp->granulos_completos) == cp->num_granulos;
+    if (!fin && ahora - ultimo < cp->intervalo_ns) return;
+    if (atomic_compare_exchange_strong(&cp->ultimo_guardado_ns, &ultimo, ahora)) checkpoint_guardar(cp);
+}
+
+#endif // CHECKPOINT_H
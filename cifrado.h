@@ -0,0 +1,35 @@
+#ifndef CIFRADO_H
+#define CIFRADO_H
+
+#include "memInfo.h"
+#include "registro.h"
+#include "cifrado_xor.h"
+#include "cifrado_chacha.h"
+
+// Interfaz de cifrado de emisores y receptores. Cifrar y descifrar son la misma
+// operacion (combinar con un keystream) y cada unidad se procesa sola a partir de
+// su offset en la fuente, asi que cualquier trabajador puede tomar cualquier unidad.
+//   CIFRADO_XOR:      un byte fijo (llave_desencriptar) para todas las posiciones
+//   CIFRADO_CHACHA20: keystream ChaCha20 en el offset de cada byte (cifrado_chacha.h);
+//                     con manifiesto el trabajo entra en el nonce para no repetir keystream
+
+// Elige los kernels antes del fork para que los hijos hereden la eleccion
+static inline void cifrado_preparar(void) {
+    xor_kernel();
+    chacha_kernel();
+}
+
+static inline const char *cifrado_nombre(int algoritmo) {
+    return algoritmo == CIFRADO_CHACHA20 ? "chacha20" : "xor";
+}
+
+static inline void cifrado_aplicar(const struct MemoriaCompartida *memoria, struct Bloque *item) {
+    if (memoria->algoritmo_cifrado == CIFRADO_CHACHA20) {
+        uint64_t nonce = memoria->nonce_chacha ^ ((uint64_t)(uint32_t)item->trabajo << 32);
+        chacha_aplicar(memoria->clave_chacha, nonce, (uint64_t)item->offset_fuente, item->datos, item->longitud);
+    } else {
+        xor_aplicar(item->datos, item->longitud, memoria->llave_desencriptar);
+    }
+}
+
+#endif // CIFRADO_H
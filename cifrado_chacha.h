@@ -0,0 +1,287 @@
+#ifndef CIFRADO_CHACHA_H
+#define CIFRADO_CHACHA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Cifrado de flujo ChaCha20 en modo contador, direccionado por offset: el byte
+// en la posicion p de la fuente se combina con el byte p % 64 del bloque de
+// keystream p / 64. Cualquier trabajador cifra o descifra cualquier rango sin
+// depender de los demas, igual que con el XOR.
+//
+// Se usa la variante original de ChaCha20 (contador de bloque de 64 bits en las
+// palabras 12-13 y nonce de 64 bits en 14-15), asi que no hay limite practico
+// de tamano de fuente. Hay una version escalar de referencia y, en x86,
+// variantes SSE2 (4 bloques a la vez) y AVX2 (8 bloques) que se eligen en
+// tiempo de ejecucion; antes de adoptar una se compara contra la escalar.
+
+#define CHACHA_BLOQUE 64
+
+typedef void (*FuncionChacha)(const uint32_t clave[8], uint64_t nonce, uint64_t bloque,
+                              unsigned char *datos, size_t bloques);
+
+#define CHACHA_ROTL(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+#define CHACHA_CUARTO(a, b, c, d) \
+    a += b; d ^= a; d = CHACHA_ROTL(d, 16); \
+    c += d; b ^= c; b = CHACHA_ROTL(b, 12); \
+    a += b; d ^= a; d = CHACHA_ROTL(d, 8);  \
+    c += d; b ^= c; b = CHACHA_ROTL(b, 7);
+
+static inline void chacha_estado(uint32_t estado[16], const uint32_t clave[8], uint64_t nonce, uint64_t bloque) {
+    estado[0] = 0x61707865; estado[1] = 0x3320646e; estado[2] = 0x79622d32; estado[3] = 0x6b206574;
+    memcpy(&estado[4], clave, 8 * sizeof(uint32_t));
+    estado[12] = (uint32_t)bloque;
+    estado[13] = (uint32_t)(bloque >> 32);
+    estado[14] = (uint32_t)nonce;
+    estado[15] = (uint32_t)(nonce >> 32);
+}
+
+// Un bloque de keystream, serializado en little-endian
+static void chacha_bloque(const uint32_t clave[8], uint64_t nonce, uint64_t bloque, unsigned char salida[CHACHA_BLOQUE]) {
+    uint32_t entrada[16], x[16];
+    chacha_estado(entrada, clave, nonce, bloque);
+    memcpy(x, entrada, sizeof(x));
+    for (int i = 0; i < 10; i++) {
+        CHACHA_CUARTO(x[0], x[4], x[8],  x[12]);
+        CHACHA_CUARTO(x[1], x[5], x[9],  x[13]);
+        CHACHA_CUARTO(x[2], x[6], x[10], x[14]);
+        CHACHA_CUARTO(x[3], x[7], x[11], x[15]);
+        CHACHA_CUARTO(x[0], x[5], x[10], x[15]);
+        CHACHA_CUARTO(x[1], x[6], x[11], x[12]);
+        CHACHA_CUARTO(x[2], x[7], x[8],  x[13]);
+        CHACHA_CUARTO(x[3], x[4], x[9],  x[14]);
+    }
+    for (int i = 0; i < 16; i++) {
+        uint32_t v = x[i] + entrada[i];
+        salida[4 * i]     = (unsigned char)v;
+        salida[4 * i + 1] = (unsigned char)(v >> 8);
+        salida[4 * i + 2] = (unsigned char)(v >> 16);
+        salida[4 * i + 3] = (unsigned char)(v >> 24);
+    }
+}
+
+// Combina 'bloques' bloques completos de 'datos' con el keystream desde 'bloque'
+static void chacha_escalar(const uint32_t clave[8], uint64_t nonce, uint64_t bloque,
+                           unsigned char *datos, size_t bloques) {
+    unsigned char flujo[CHACHA_BLOQUE];
+    for (size_t b = 0; b < bloques; b++) {
+        chacha_bloque(clave, nonce, bloque + b, flujo);
+        for (int i = 0; i < CHACHA_BLOQUE; i++) datos[b * CHACHA_BLOQUE + i] ^= flujo[i];
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+// Cada vector lleva la misma palabra de varios bloques consecutivos (un bloque por
+// carril). Tras las rondas se transponen 4x4 para recuperar los bytes de cada bloque.
+
+#define CHACHA_SSE2_ROTL(v, n) _mm_or_si128(_mm_slli_epi32(v, n), _mm_srli_epi32(v, 32 - (n)))
+#define CHACHA_SSE2_CUARTO(a, b, c, d) \
+    a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = CHACHA_SSE2_ROTL(d, 16); \
+    c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = CHACHA_SSE2_ROTL(b, 12); \
+    a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = CHACHA_SSE2_ROTL(d, 8);  \
+    c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = CHACHA_SSE2_ROTL(b, 7);
+
+__attribute__((target("sse2")))
+static void chacha_sse2(const uint32_t clave[8], uint64_t nonce, uint64_t bloque,
+                        unsigned char *datos, size_t bloques) {
+    size_t b = 0;
+    for (; b + 4 <= bloques; b += 4) {
+        uint32_t estado[16];
+        chacha_estado(estado, clave, nonce, bloque + b);
+        __m128i entrada[16], x[16];
+        for (int i = 0; i < 16; i++) entrada[i] = _mm_set1_epi32((int)estado[i]);
+        // El contador de 64 bits de cada carril, con acarreo a la palabra alta
+        uint32_t bajo[4], alto[4];
+        for (int l = 0; l < 4; l++) {
+            uint64_t contador = bloque + b + l;
+            bajo[l] = (uint32_t)contador;
+            alto[l] = (uint32_t)(contador >> 32);
+        }
+        entrada[12] = _mm_setr_epi32((int)bajo[0], (int)bajo[1], (int)bajo[2], (int)bajo[3]);
+        entrada[13] = _mm_setr_epi32((int)alto[0], (int)alto[1], (int)alto[2], (int)alto[3]);
+        for (int i = 0; i < 16; i++) x[i] = entrada[i];
+
+        for (int i = 0; i < 10; i++) {
+            CHACHA_SSE2_CUARTO(x[0], x[4], x[8],  x[12]);
+            CHACHA_SSE2_CUARTO(x[1], x[5], x[9],  x[13]);
+            CHACHA_SSE2_CUARTO(x[2], x[6], x[10], x[14]);
+            CHACHA_SSE2_CUARTO(x[3], x[7], x[11], x[15]);
+            CHACHA_SSE2_CUARTO(x[0], x[5], x[10], x[15]);
+            CHACHA_SSE2_CUARTO(x[1], x[6], x[11], x[12]);
+            CHACHA_SSE2_CUARTO(x[2], x[7], x[8],  x[13]);
+            CHACHA_SSE2_CUARTO(x[3], x[4], x[9],  x[14]);
+        }
+        for (int i = 0; i < 16; i++) x[i] = _mm_add_epi32(x[i], entrada[i]);
+
+        // Grupo g = palabras 4g..4g+3; tras transponer, fila l = 16 bytes del bloque l
+        unsigned char *destino = datos + b * CHACHA_BLOQUE;
+        for (int g = 0; g < 4; g++) {
+            __m128i t0 = _mm_unpacklo_epi32(x[4 * g],     x[4 * g + 1]);
+            __m128i t1 = _mm_unpacklo_epi32(x[4 * g + 2], x[4 * g + 3]);
+            __m128i t2 = _mm_unpackhi_epi32(x[4 * g],     x[4 * g + 1]);
+            __m128i t3 = _mm_unpackhi_epi32(x[4 * g + 2], x[4 * g + 3]);
+            __m128i fila[4] = {
+                _mm_unpacklo_epi64(t0, t1), _mm_unpackhi_epi64(t0, t1),
+                _mm_unpacklo_epi64(t2, t3), _mm_unpackhi_epi64(t2, t3),
+            };
+            for (int l = 0; l < 4; l++) {
+                __m128i *p = (__m128i *)(destino + l * CHACHA_BLOQUE + 16 * g);
+                _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), fila[l]));
+            }
+        }
+    }
+    chacha_escalar(clave, nonce, bloque + b, datos + b * CHACHA_BLOQUE, bloques - b);
+}
+
+#define CHACHA_AVX2_ROTL(v, n) _mm256_or_si256(_mm256_slli_epi32(v, n), _mm256_srli_epi32(v, 32 - (n)))
+#define CHACHA_AVX2_CUARTO(a, b, c, d) \
+    a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a); d = _mm256_shuffle_epi8(d, rot16); \
+    c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = CHACHA_AVX2_ROTL(b, 12);      \
+    a = _mm256_add_epi32(a, b); d = _mm256_xor_si256(d, a); d = _mm256_shuffle_epi8(d, rot8);  \
+    c = _mm256_add_epi32(c, d); b = _mm256_xor_si256(b, c); b = CHACHA_AVX2_ROTL(b, 7);
+
+__attribute__((target("avx2")))
+static void chacha_avx2(const uint32_t clave[8], uint64_t nonce, uint64_t bloque,
+                        unsigned char *datos, size_t bloques) {
+    // Las rotaciones de 16 y 8 bits son permutaciones de bytes dentro de cada palabra
+    const __m256i rot16 = _mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+                                           2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    const __m256i rot8 = _mm256_setr_epi8(3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14,
+                                          3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14);
+    size_t b = 0;
+    for (; b + 8 <= bloques; b += 8) {
+        uint32_t estado[16];
+        chacha_estado(estado, clave, nonce, bloque + b);
+        __m256i entrada[16], x[16];
+        for (int i = 0; i < 16; i++) entrada[i] = _mm256_set1_epi32((int)estado[i]);
+        uint32_t bajo[8], alto[8];
+        for (int l = 0; l < 8; l++) {
+            uint64_t contador = bloque + b + l;
+            bajo[l] = (uint32_t)contador;
+            alto[l] = (uint32_t)(contador >> 32);
+        }
+        entrada[12] = _mm256_loadu_si256((const __m256i *)bajo);
+        entrada[13] = _mm256_loadu_si256((const __m256i *)alto);
+        for (int i = 0; i < 16; i++) x[i] = entrada[i];
+
+        for (int i = 0; i < 10; i++) {
+            CHACHA_AVX2_CUARTO(x[0], x[4], x[8],  x[12]);
+            CHACHA_AVX2_CUARTO(x[1], x[5], x[9],  x[13]);
+            CHACHA_AVX2_CUARTO(x[2], x[6], x[10], x[14]);
+            CHACHA_AVX2_CUARTO(x[3], x[7], x[11], x[15]);
+            CHACHA_AVX2_CUARTO(x[0], x[5], x[10], x[15]);
+            CHACHA_AVX2_CUARTO(x[1], x[6], x[11], x[12]);
+            CHACHA_AVX2_CUARTO(x[2], x[7], x[8],  x[13]);
+            CHACHA_AVX2_CUARTO(x[3], x[4], x[9],  x[14]);
+        }
+        for (int i = 0; i < 16; i++) x[i] = _mm256_add_epi32(x[i], entrada[i]);
+
+        // Transposicion 4x4 dentro de cada mitad de 128 bits: fila[g][l] lleva las palabras
+        // 4g..4g+3 del bloque l (mitad baja) y del bloque l + 4 (mitad alta)
+        __m256i fila[4][4];
+        for (int g = 0; g < 4; g++) {
+            __m256i t0 = _mm256_unpacklo_epi32(x[4 * g],     x[4 * g + 1]);
+            __m256i t1 = _mm256_unpacklo_epi32(x[4 * g + 2], x[4 * g + 3]);
+            __m256i t2 = _mm256_unpackhi_epi32(x[4 * g],     x[4 * g + 1]);
+            __m256i t3 = _mm256_unpackhi_epi32(x[4 * g + 2], x[4 * g + 3]);
+            fila[g][0] = _mm256_unpacklo_epi64(t0, t1);
+            fila[g][1] = _mm256_unpackhi_epi64(t0, t1);
+            fila[g][2] = _mm256_unpacklo_epi64(t2, t3);
+            fila[g][3] = _mm256_unpackhi_epi64(t2, t3);
+        }
+        unsigned char *destino = datos + b * CHACHA_BLOQUE;
+        for (int l = 0; l < 4; l++) {
+            __m256i bloques_l[4] = {
+                _mm256_permute2x128_si256(fila[0][l], fila[1][l], 0x20),   // Bloque l, bytes 0..31
+                _mm256_permute2x128_si256(fila[2][l], fila[3][l], 0x20),   // Bloque l, bytes 32..63
+                _mm256_permute2x128_si256(fila[0][l], fila[1][l], 0x31),   // Bloque l + 4, bytes 0..31
+                _mm256_permute2x128_si256(fila[2][l], fila[3][l], 0x31),   // Bloque l + 4, bytes 32..63
+            };
+            __m256i *p[4] = {
+                (__m256i *)(destino + l * CHACHA_BLOQUE),       (__m256i *)(destino + l * CHACHA_BLOQUE + 32),
+                (__m256i *)(destino + (l + 4) * CHACHA_BLOQUE), (__m256i *)(destino + (l + 4) * CHACHA_BLOQUE + 32),
+            };
+            for (int k = 0; k < 4; k++) {
+                _mm256_storeu_si256(p[k], _mm256_xor_si256(_mm256_loadu_si256(p[k]), bloques_l[k]));
+            }
+        }
+    }
+    chacha_sse2(clave, nonce, bloque + b, datos + b * CHACHA_BLOQUE, bloques - b);
+}
+#endif
+
+// Compara una variante contra la escalar con varios contadores (incluido el acarreo
+// a la palabra alta) y cantidades de bloques que no son multiplo del ancho
+static int chacha_variante_valida(FuncionChacha variante) {
+    static const uint32_t clave[8] = { 0x03020100, 0x07060504, 0x0b0a0908, 0x0f0e0d0c,
+                                       0x13121110, 0x17161514, 0x1b1a1918, 0x1f1e1d1c };
+    const uint64_t inicios[] = { 0, 1, 0xfffffffdULL, 0x123456789ULL };
+    unsigned char esperado[19 * CHACHA_BLOQUE], obtenido[19 * CHACHA_BLOQUE];
+    for (size_t i = 0; i < sizeof(inicios) / sizeof(inicios[0]); i++) {
+        for (size_t bloques = 0; bloques <= 19; bloques += 3) {
+            for (size_t j = 0; j < sizeof(esperado); j++) esperado[j] = (unsigned char)(j * 31 + 7);
+            memcpy(obtenido, esperado, sizeof(esperado));
+            chacha_escalar(clave, 0x4a00000009000000ULL, inicios[i], esperado, bloques);
+            variante(clave, 0x4a00000009000000ULL, inicios[i], obtenido, bloques);
+            if (memcmp(esperado, obtenido, sizeof(esperado)) != 0) return 0;
+        }
+    }
+    return 1;
+}
+
+static FuncionChacha chacha_funcion = NULL;
+static const char *chacha_nombre = "escalar";
+
+// Elige (una sola vez por proceso) la variante mas ancha soportada y verificada
+static FuncionChacha chacha_kernel(void) {
+    if (chacha_funcion != NULL) return chacha_funcion;
+    chacha_funcion = chacha_escalar;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    struct { const char *nombre; int soportada; FuncionChacha funcion; } candidatas[] = {
+        { "avx2", __builtin_cpu_supports("avx2"), chacha_avx2 },
+        { "sse2", __builtin_cpu_supports("sse2"), chacha_sse2 },
+    };
+    for (size_t i = 0; i < sizeof(candidatas) / sizeof(candidatas[0]); i++) {
+        if (candidatas[i].soportada && chacha_variante_valida(candidatas[i].funcion)) {
+            chacha_funcion = candidatas[i].funcion;
+            chacha_nombre = candidatas[i].nombre;
+            break;
+        }
+    }
+#endif
+    return chacha_funcion;
+}
+
+// Cifra o descifra (es la misma operacion) 'len' bytes cuyo primer byte esta en
+// 'offset' del flujo: los bordes parciales van por la version escalar
+static inline void chacha_aplicar(const uint32_t clave[8], uint64_t nonce, uint64_t offset,
+                                  unsigned char *datos, size_t len) {
+    unsigned char flujo[CHACHA_BLOQUE];
+    uint64_t bloque = offset / CHACHA_BLOQUE;
+    size_t desfase = offset % CHACHA_BLOQUE;
+    if (desfase != 0 && len > 0) {
+        chacha_bloque(clave, nonce, bloque, flujo);
+        size_t n = CHACHA_BLOQUE - desfase < len ? CHACHA_BLOQUE - desfase : len;
+        for (size_t i = 0; i < n; i++) datos[i] ^= flujo[desfase + i];
+        datos += n;
+        len -= n;
+        bloque++;
+    }
+    size_t completos = len / CHACHA_BLOQUE;
+    if (completos > 0) {
+        chacha_kernel()(clave, nonce, bloque, datos, completos);
+        datos += completos * CHACHA_BLOQUE;
+        len -= completos * CHACHA_BLOQUE;
+        bloque += completos;
+    }
+    if (len > 0) {
+        chacha_bloque(clave, nonce, bloque, flujo);
+        for (size_t i = 0; i < len; i++) datos[i] ^= flujo[i];
+    }
+}
+
+#endif // CIFRADO_CHACHA_H
@@ -1,3 +1,4 @@
+#define _GNU_SOURCE     // Para sched_setaffinity (afinidad.h)
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -6,11 +7,24 @@
 #include <sys/mman.h>   // Para shm_opne, mmap
 #include <sys/stat.h>   // Para fstat
 #include <sys/wait.h>   // Para wait
-#include <semaphore.h>  // Para sem_open, sem_wait, sem_post
 #include <errno.h>      // Para EINTR
 #include <time.h>       // Para time, strftime
 #include <ctype.h>      // Para isprint
+#include <sched.h>      // Para sched_yield
+#include <pthread.h>    // Para el modo --hilos
 #include "memInfo.h"    // Archivo de cabecera
+#include "registro.h"   // Formato de las celdas del buffer
+#include "anillo.h"     // Anillo sin locks
+#include "fragmentos.h" // Un anillo por emisor
+#include "sincronizacion.h" // Semaforos POSIX o futex
+#include "cifrado.h"    // XOR o ChaCha20 por offset, con kernels vectorizados
+#include "bitacora.h"   // Bitacora binaria del modo silencioso
+#include "metricas.h"   // Metricas en vivo por trabajador
+#include "afinidad.h"   // Fijacion de trabajadores a CPUs
+#include "segmento.h"   // Apertura del segmento (shm o hugetlbfs)
+#include "redimension.h" // Buffer que crece y se reduce en linea
+#include "flujo.h"      // Cola de trozos del lector (--lectura flujo)
+#include "trabajos.h"   // Tabla de trabajos de --manifiesto
 
 // --- Codigos de color ANSI para la impresion elegante
 #define ANSI_COLOR_CYAN     "\x1b[36m"    
@@ -25,196 +39,537 @@ void reportar_error_y_salir(const char *msg) {
     exit(EXIT_FAILURE);
 }
 
-// Imprime de forma tabular y con colores la informacion del caracter producido
-void imprimir_produccion(const struct CharInfo* info, char char_original) {
+// Imprime de forma tabular y con colores la informacion del caracter (o bloque) producido
+void imprimir_produccion(const struct MemoriaCompartida *memoria, const struct Bloque* info, unsigned char clave) {
     char time_str[64];
-    strftime(time_str, sizeof(time_str), "%H:%M:%S", localtime(&info->timestamp));
-    char original_printable = isprint(char_original) ? char_original : '?';
-    char cifrado_printable = isprint(info->valor_ascii) ? info->valor_ascii : '?';
+    time_t hora = registro_hora(memoria, info->t_encolado_ns);
+    strftime(time_str, sizeof(time_str), "%H:%M:%S", localtime(&hora));
 
     const char* colors[] = { ANSI_COLOR_CYAN, ANSI_COLOR_GREEN, ANSI_COLOR_YELLOW, ANSI_COLOR_MAGENTA };
-    const char* color = colors[getpid() % 4];   // Elige un color basado en el PID
+    const char* color = colors[id_trabajador() % 4];   // Elige un color basado en el TID
 
     /* Use a literal format string to avoid -Wformat-security warnings */
-    printf("%s[EMISOR (PID: %d)]%s -> | ", color, getpid(), ANSI_COLOR_RESET);
-    printf("Original: " ANSI_COLOR_YELLOW "'%c'" ANSI_COLOR_RESET " | ", original_printable);
-    printf("Cifrado: " ANSI_COLOR_GREEN "'%c' (0x%02X)" ANSI_COLOR_RESET " | ", cifrado_printable, (unsigned char)info->valor_ascii);
+    printf("%s[EMISOR (PID: %d)]%s -> | ", color, id_trabajador(), ANSI_COLOR_RESET);
+    if (info->longitud == 1) {
+        char char_original = (char)(info->datos[0] ^ clave);
+        char original_printable = isprint(char_original) ? char_original : '?';
+        char cifrado_printable = isprint(info->datos[0]) ? (char)info->datos[0] : '?';
+        printf("Original: " ANSI_COLOR_YELLOW "'%c'" ANSI_COLOR_RESET " | ", original_printable);
+        printf("Cifrado: " ANSI_COLOR_GREEN "'%c' (0x%02X)" ANSI_COLOR_RESET " | ", cifrado_printable, info->datos[0]);
+    } else {
+        printf("Bloque: " ANSI_COLOR_YELLOW "%d bytes" ANSI_COLOR_RESET " | ", info->longitud);
+        printf("Offset: " ANSI_COLOR_GREEN "%ld" ANSI_COLOR_RESET " | ", info->offset_fuente);
+    }
     /* Print index with matching format and argument */
     printf("Indice: %-4d | ", info->indice);
     printf("Hora: %s |\n", time_str);
 }
 
+// Origen de los bytes del archivo fuente: mapeo en memoria, stdio o, con
+// LECTURA_FLUJO, el trozo que el emisor tomo de la cola del lector
+struct FuenteEmisor {
+    FILE *archivo;                  // Respaldo stdio (NULL si se usa el mapeo)
+    const unsigned char *mapa;      // Archivo mapeado de solo lectura (NULL si se usa stdio)
+    long tam;                       // Tamano del archivo si es regular, -1 si se desconoce
+    const unsigned char *trozo;     // LECTURA_FLUJO: datos del trozo actual (NULL si no hay)
+    long trozo_inicio;              // Posicion en la fuente de trozo[0]
+};
+
+// Abre el archivo fuente. Intenta mapearlo si se solicita y, si no se puede
+// (no es regular, esta vacio o mmap falla), recurre a fopen.
+void fuente_abrir(struct FuenteEmisor *fuente, const char *ruta, int usar_mmap) {
+    fuente->archivo = NULL;
+    fuente->mapa = NULL;
+    fuente->tam = -1;
+    fuente->trozo = NULL;
+
+    int fd = open(ruta, O_RDONLY);
+    if (fd == -1) {
+        fprintf(stderr, "Error (PID %d) al abrir el archivo fuente: %s\n", getpid(), ruta);
+        reportar_error_y_salir("open");
+    }
 
-// Logica principal del emisor - Cada proceso HIJO (creado por fork) ejecutara esta funcion
-void emisor_worker(const char* shm_name, const char* modo_ejecucion) {
-    // Validar modo
-    int modo_manual = 0;
-    if (strcmp(modo_ejecucion, "manual") == 0) {
-        modo_manual = 1;
-        printf (ANSI_COLOR_CYAN "[WORKER (PID: %d)] Modo: Manual\n" ANSI_COLOR_RESET, getpid());
-    } else if (strcmp(modo_ejecucion, "automatico") != 0) {
-        fprintf(stderr, "[ERROR (PID %d)]: Modo debe ser 'manual' o 'automatico'.\n", getpid());
-        exit(EXIT_FAILURE);
+    struct stat fuente_stat;
+    if (fstat(fd, &fuente_stat) == 0 && S_ISREG(fuente_stat.st_mode)) {
+        fuente->tam = fuente_stat.st_size;
+    }
+
+    if (usar_mmap && fuente->tam > 0) {
+        void *mapa = mmap(NULL, fuente->tam, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapa != MAP_FAILED) {
+            madvise(mapa, fuente->tam, MADV_SEQUENTIAL);
+            fuente->mapa = (const unsigned char *)mapa;
+            close(fd);
+            return;
+        }
     }
 
-    // --- Generar Nombres de Semaforos ---
-    char sem_mutex_name[512], sem_empty_name[512], sem_full_name[512], sem_fin_name[512];
-    int r;
-    r = snprintf(sem_mutex_name, sizeof(sem_mutex_name), "%s%s", shm_name, SEM_MUTEX_NAME_SUFFIX);
-    if (r < 0 || (size_t)r >= sizeof(sem_mutex_name)) reportar_error_y_salir("sem name snprintf (mutex) truncated");
-    r = snprintf(sem_empty_name, sizeof(sem_empty_name), "%s%s", shm_name, SEM_EMPTY_NAME_SUFFIX);
-    if (r < 0 || (size_t)r >= sizeof(sem_empty_name)) reportar_error_y_salir("sem name snprintf (empty) truncated");
-    r = snprintf(sem_full_name, sizeof(sem_full_name), "%s%s", shm_name, SEM_FULL_NAME_SUFFIX);
-    if (r < 0 || (size_t)r >= sizeof(sem_full_name)) reportar_error_y_salir("sem name snprintf (full) truncated");
-    r = snprintf(sem_fin_name, sizeof(sem_fin_name), "%s%s", shm_name, SEM_FIN_NAME_SUFFIX);
-    if (r < 0 || (size_t)r >= sizeof(sem_fin_name)) reportar_error_y_salir("sem name snprintf (fin) truncated");
+    fuente->archivo = fdopen(fd, "r");
+    if (fuente->archivo == NULL) reportar_error_y_salir("fdopen");
+}
 
-    // --- Conectar a los Recursos IPC ---
-    sem_t *sem_mutex = sem_open(sem_mutex_name, 0);
-    if (sem_mutex == SEM_FAILED) reportar_error_y_salir("Error en sem_open (mutex)");
-    sem_t *sem_empty = sem_open(sem_empty_name, 0);
-    if (sem_empty == SEM_FAILED) reportar_error_y_salir("Error en sem_open (empty)");
-    sem_t *sem_full = sem_open(sem_full_name, 0);
-    if (sem_full == SEM_FAILED) reportar_error_y_salir("Error en sem_open (full)");
-    sem_t *sem_fin = sem_open(sem_fin_name, 0);
-    if (sem_fin == SEM_FAILED) reportar_error_y_salir("Error en sem_open (fin)");
-
-    int shm_fd = shm_open(shm_name, O_RDWR, 0666);
+// Prepara la lectura del rango [inicio, fin) recien reclamado
+int fuente_preparar_rango(struct FuenteEmisor *fuente, long inicio, long fin) {
+    if (fuente->mapa != NULL) {
+        // Pedir al kernel que adelante la lectura de las paginas del rango
+        long pagina = sysconf(_SC_PAGESIZE);
+        long inicio_alineado = inicio - (inicio % pagina);
+        madvise((void *)(fuente->mapa + inicio_alineado), fin - inicio_alineado, MADV_WILLNEED);
+        return 0;
+    }
+    // El rango es contiguo: basta un fseek al inicio y luego lectura secuencial
+    return fseek(fuente->archivo, inicio, SEEK_SET);
+}
+
+// Devuelve el byte en la posicion indicada (o EOF). En modo stdio las
+// posiciones deben pedirse en orden dentro del rango preparado.
+int fuente_leer(struct FuenteEmisor *fuente, long posicion) {
+    if (fuente->trozo != NULL) return fuente->trozo[posicion - fuente->trozo_inicio];
+    if (fuente->mapa != NULL) {
+        return (posicion < fuente->tam) ? fuente->mapa[posicion] : EOF;
+    }
+    return fgetc(fuente->archivo);
+}
+
+void fuente_cerrar(struct FuenteEmisor *fuente) {
+    if (fuente->mapa != NULL) munmap((void *)fuente->mapa, fuente->tam);
+    if (fuente->archivo != NULL) fclose(fuente->archivo);
+}
+
+// Opciones del lanzador que se pasan a cada emisor
+struct OpcionesEmisor {
+    int modo_manual;                // 1 = esperar ENTER antes de cada insercion
+    int hilos;                      // 1 = emisores como pthreads de un solo proceso
+    const char *dir_bitacora;       // Modo silencioso: directorio de la bitacora binaria (NULL = imprimir tabla)
+    struct Afinidad afinidad;       // CPUs a las que se fija cada emisor (--cpus)
+};
+
+// Recursos del segmento que usa un emisor. Cada proceso hijo abre los suyos;
+// en modo hilos el lanzador los abre una sola vez y todos los hilos los comparten.
+struct RecursosEmisor {
+    struct MemoriaCompartida *memoria;
+    size_t total_size;              // Bytes mapeados (tam_mapeo si el buffer es redimensionable)
+    int shm_fd;                     // Abierto solo si el buffer es redimensionable (-1 si no)
+    struct Sincronizacion sync;
+    struct ColaTrozos *cola;        // LECTURA_FLUJO: cola de trozos del lector (NULL si no)
+    size_t tam_cola;
+    struct TablaTrabajos *tabla;    // --manifiesto: tabla de trabajos (NULL si no)
+    size_t tam_tabla;
+};
+
+void recursos_emisor_abrir(struct RecursosEmisor *recursos, const char *shm_name) {
+    int shm_fd = segmento_abrir(shm_name, O_RDWR);
     if (shm_fd == -1) reportar_error_y_salir("Error en shm_open");
 
-    struct stat shm_stat;
-    if (fstat(shm_fd, &shm_stat) == -1) reportar_error_y_salir("fstat");
-    size_t total_size = shm_stat.st_size;
+    size_t tam_archivo;
+    recursos->memoria = redimension_mapear(shm_fd, &recursos->total_size, &tam_archivo);
+    segmento_preparar(recursos->memoria, tam_archivo);
 
-    struct MemoriaCompartida *memoria = (struct MemoriaCompartida *)mmap(
-        NULL, total_size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0
-    );
-    close(shm_fd);
+    // Con buffer redimensionable el emisor que lo cambie necesita el descriptor para ftruncate
+    recursos->shm_fd = -1;
+    if (recursos->memoria->redimension) recursos->shm_fd = shm_fd;
+    else close(shm_fd);
 
-    if (memoria == MAP_FAILED) reportar_error_y_salir("mmap");
+    sincronizacion_abrir(&recursos->sync, shm_name, recursos->memoria);
 
-    // --- Abrir el archivo guente (cada hijo abre su propia copia) ---
-    FILE *archivo_fuente = fopen(memoria->archivo_fuente, "r");
-    if (archivo_fuente == NULL) {
-        fprintf(stderr, "Error (PID %d) al abrir el archivo fuente: %s\n", getpid(), memoria->archivo_fuente);
-        reportar_error_y_salir("fopen");
-    }
+    recursos->cola = NULL;
+    if (recursos->memoria->modo_lectura == LECTURA_FLUJO) recursos->cola = flujo_abrir(shm_name, &recursos->tam_cola);
 
-    unsigned char clave_codificar = memoria->llave_desencriptar;
+    recursos->tabla = NULL;
+    if (recursos->memoria->manifiesto) recursos->tabla = trabajos_abrir(shm_name, &recursos->tam_tabla);
+}
 
-    if (sem_wait(sem_mutex) == -1) reportar_error_y_salir("sem_wait (mutex register)");
-    memoria->emisores_activos++;
-    if (sem_post(sem_mutex) == -1) reportar_error_y_salir("sem_post (mutex register)");
+void recursos_emisor_cerrar(struct RecursosEmisor *recursos) {
+    if (recursos->cola != NULL) flujo_cerrar(recursos->cola, recursos->tam_cola);
+    if (recursos->tabla != NULL) trabajos_cerrar(recursos->tabla, recursos->tam_tabla);
+    munmap(recursos->memoria, recursos->total_size);
+    if (recursos->shm_fd != -1) close(recursos->shm_fd);
+    sincronizacion_cerrar(&recursos->sync);
+}
 
-    // --- Loop Principal del emisor ---
-    for (;;) {
-        int char_leido;
-        int mi_indice_archivo;
-
-        // --- INICIO SECCION CRITICA (INDICE DE ARCHIVO) ---
-        if (sem_wait(sem_mutex) == -1) {
-            if (errno == EINTR) continue;
-            reportar_error_y_salir("sem_wait (mutex get work)");
-        }
-        
-        // --- CHEQUEO DE CIERRE ---
-        if (memoria->shutdown_flag) {
-            sem_post(sem_mutex);
-            break;
+// Bucle de un emisor (proceso o hilo): registro, produccion hasta el fin del
+// archivo o el cierre, y baja. No libera los recursos compartidos.
+void emisor_bucle(struct RecursosEmisor *recursos, struct FuenteEmisor *fuente_compartida,
+                  const struct OpcionesEmisor *opciones) {
+    struct MemoriaCompartida *memoria = recursos->memoria;
+    struct Sincronizacion sync = recursos->sync;
+    int modo_manual = opciones->modo_manual;
+    if (modo_manual) {
+        printf (ANSI_COLOR_CYAN "[WORKER (PID: %d)] Modo: Manual\n" ANSI_COLOR_RESET, id_trabajador());
+    }
+
+    // --- Abrir el archivo fuente ---
+    // Un mapeo se puede compartir entre hilos; con stdio cada trabajador necesita su propia posicion.
+    // Con LECTURA_FLUJO la fuente solo la lee el lector: los bytes llegan en trozos de su cola.
+    // Con --manifiesto cada rango es de un trabajo y se abre la fuente de ese trabajo al reclamarlo.
+    struct ColaTrozos *cola = recursos->cola;
+    long trozo_actual = -1;     // Posicion en la cola del trozo que se esta procesando
+    struct TablaTrabajos *tabla = recursos->tabla;
+    int trabajo_rango = -1;     // Trabajo del rango reclamado (-1 = ninguno abierto)
+    int trabajo_fuente = -1;    // Trabajo cuya fuente esta abierta en 'fuente'
+    struct FuenteEmisor fuente_propia;
+    memset(&fuente_propia, 0, sizeof(fuente_propia));
+    fuente_propia.tam = -1;
+    struct FuenteEmisor *fuente_ptr = fuente_compartida;
+    if (cola != NULL || tabla != NULL) {
+        fuente_ptr = &fuente_propia;
+    } else if (fuente_ptr == NULL) {
+        fuente_abrir(&fuente_propia, memoria->archivo_fuente, memoria->modo_lectura == LECTURA_MMAP);
+        fuente_ptr = &fuente_propia;
+    }
+    struct FuenteEmisor fuente = *fuente_ptr;
+
+    // Tamano del archivo fuente (si es regular) para no reclamar mas alla del final
+    long tam_fuente = fuente.tam;
+
+    // En modo manual se reclama de a un caracter para que los emisores se intercalen
+    long tam_reclamo = modo_manual ? 1 : memoria->tam_reclamo;
+    long rango_actual = 0;  // Proximo indice del rango reclamado por este emisor
+    long rango_fin = 0;     // Fin (exclusivo) del rango reclamado
+    int fin_de_archivo = 0;
+
+    // Unidad que se envia por el buffer: un caracter o una corrida de hasta tam_bloque bytes
+    struct Bloque item;
+    item.datos = malloc(memoria->tam_bloque);
+    if (item.datos == NULL) reportar_error_y_salir("malloc (bloque)");
+    item.trabajo = 0;
+
+    // En modo silencioso cada produccion se anota en la bitacora en vez de imprimirse
+    struct Bitacora *bitacora = NULL;
+    if (opciones->dir_bitacora != NULL) {
+        bitacora = malloc(sizeof(*bitacora));
+        if (bitacora == NULL) reportar_error_y_salir("malloc (bitacora)");
+        bitacora_abrir(bitacora, opciones->dir_bitacora, EVENTO_EMISOR);
+    }
+
+    // Con anillos fragmentados cada emisor es el unico productor de su anillo: espera
+    // en los 'libres' de ese anillo en lugar de sem_empty y publica sin sem_full
+    int fragmentado = memoria->protocolo_anillo == ANILLO_FRAGMENTADO;
+    int mi_fragmento = -1;
+    struct Semaforo libres_propios, llenos_propios;
+    if (fragmentado) {
+        mi_fragmento = atomic_fetch_add(&memoria->productores.fragmentos_asignados, 1);
+        if (mi_fragmento >= memoria->num_fragmentos) {
+            fprintf(stderr, "Error: no quedan anillos libres (%d fragmentos).\n", memoria->num_fragmentos);
+            exit(EXIT_FAILURE);
         }
+        libres_propios = fragmento_semaforo(memoria, &fragmento(memoria, mi_fragmento)->libres);
+        llenos_propios = fragmento_semaforo(memoria, &fragmento(memoria, mi_fragmento)->llenos);
+    }
+    struct Semaforo *espacio = fragmentado ? &libres_propios : &sync.empty;
+    struct Semaforo *ocupacion = fragmentado ? &llenos_propios : &sync.full;
+
+    if (semaforo_esperar(&sync.mutex) == -1) reportar_error_y_salir("sem_wait (mutex register)");
+    memoria->emisores_activos++;
+    if (semaforo_senalar(&sync.mutex) == -1) reportar_error_y_salir("sem_post (mutex register)");
 
-        mi_indice_archivo = memoria->idx_archivo_lectura;
-        memoria->idx_archivo_lectura++;
+    struct MetricasTrabajador *metricas = metricas_registrar(memoria, TRABAJADOR_EMISOR);
 
-        if (sem_post(sem_mutex) == -1) {
-            if (errno == EINTR) continue;
-            reportar_error_y_salir("sem_post (mutex get work)");
+    // --- Loop Principal del emisor ---
+    while (!fin_de_archivo) {
+        if (rango_actual == rango_fin && cola != NULL) {
+            // --- TOMA DEL PROXIMO TROZO DEL LECTOR (sin sem_prod: la cola reparte) ---
+            if (trozo_actual >= 0) flujo_liberar(cola, trozo_actual);
+            fuente.trozo = NULL;
+            trozo_actual = flujo_tomar(cola, &memoria->shutdown_flag, memoria->presupuesto_espera);
+            if (trozo_actual < 0) break;    // Fin del flujo o cierre
+
+            struct Trozo *trozo = flujo_trozo(cola, trozo_actual);
+            fuente.trozo = flujo_datos(cola, trozo_actual);
+            fuente.trozo_inicio = trozo->offset_fuente;
+            rango_actual = trozo->offset_fuente;
+            rango_fin = trozo->offset_fuente + trozo->longitud;
+        } else if (rango_actual == rango_fin) {
+            // El rango anterior ya esta encolado entero: puede ser el que cierra su trabajo
+            if (trabajo_rango >= 0) {
+                trabajos_cerrar_rango(tabla, trabajo_rango);
+                trabajo_rango = -1;
+            }
+
+            // --- INICIO SECCION CRITICA (RECLAMO DE RANGO DEL ARCHIVO) ---
+            long t_espera = metricas_ahora_ns();
+            if (semaforo_esperar(&sync.prod) == -1) {
+                if (errno == EINTR) continue;
+                reportar_error_y_salir("sem_wait (prod get work)");
+            }
+            long t_lock = metricas_ahora_ns();
+            metricas_sumar(&metricas->ns_espera_mutex, t_lock - t_espera);
+
+            // --- CHEQUEO DE CIERRE ---
+            if (memoria->shutdown_flag) {
+                semaforo_senalar(&sync.prod);
+                break;
+            }
+
+            // Se reclama un rango completo en una sola toma del lock, recortado al final del archivo
+            // (con manifiesto, al final del trabajo en curso o del siguiente con bytes libres)
+            long inicio = 0;
+            long cantidad = 0;
+            if (tabla != NULL) {
+                trabajo_rango = trabajos_reclamar(tabla, tam_reclamo, &inicio, &cantidad);
+            } else {
+                inicio = memoria->productores.idx_archivo_lectura;
+                cantidad = tam_reclamo;
+                if (tam_fuente >= 0 && tam_fuente - inicio < cantidad) {
+                    cantidad = (tam_fuente > inicio) ? tam_fuente - inicio : 0;
+                }
+                memoria->productores.idx_archivo_lectura = inicio + cantidad;
+            }
+
+            if (semaforo_senalar(&sync.prod) == -1) reportar_error_y_salir("sem_post (prod get work)");
+            metricas_sumar(&metricas->ns_retencion_mutex, metricas_ahora_ns() - t_lock);
+            // --- FIN SECCION CRITICA (RECLAMO DE RANGO DEL ARCHIVO) ---
+
+            if (cantidad == 0) break;   // No queda nada por leer
+
+            rango_actual = inicio;
+            rango_fin = inicio + cantidad;
+
+            if (trabajo_rango >= 0 && trabajo_rango != trabajo_fuente) {
+                if (trabajo_fuente >= 0) fuente_cerrar(&fuente);
+                fuente_abrir(&fuente, tabla->trabajos[trabajo_rango].fuente, memoria->modo_lectura == LECTURA_MMAP);
+                trabajo_fuente = trabajo_rango;
+                item.trabajo = trabajo_rango;
+            }
+
+            if (fuente_preparar_rango(&fuente, rango_actual, rango_fin) != 0) break;
         }
-        // --- FIN SECCION CRITICA (INDICE DE ARCHIVO) ---
 
-        if (fseek(archivo_fuente, mi_indice_archivo, SEEK_SET) != 0) {
-            sem_post(sem_mutex);
-            break; 
+        // --- Llenar la unidad con bytes del rango, saltando los fines de linea (salvo en orden de fuente) ---
+        item.offset_fuente = rango_actual;
+        item.longitud = 0;
+        while (item.longitud < memoria->tam_bloque && rango_actual < rango_fin) {
+            int char_leido = fuente_leer(&fuente, rango_actual);
+            if (char_leido == EOF) {
+                // Con manifiesto la fuente se acorto: termina el rango, no la corrida
+                if (tabla != NULL) rango_fin = rango_actual;
+                else fin_de_archivo = 1;
+                break;
+            }
+            rango_actual++;
+            if ((char_leido == '\n' || char_leido == '\r') && memoria->orden_salida == ORDEN_LLEGADA) {
+                if (item.longitud == 0) item.offset_fuente = rango_actual;
+                continue;
+            }
+            item.datos[item.longitud++] = (unsigned char)char_leido;
         }
-        char_leido = fgetc(archivo_fuente);
+        if (item.longitud == 0) continue;
 
-        if (char_leido == EOF) break;
-        if (char_leido == '\n' || char_leido == '\r') continue;
         if (modo_manual) {
-            printf(ANSI_COLOR_YELLOW "[EMISOR HIJO (PID: %d)] Presiones ENTER para insertar '%c'...\n" ANSI_COLOR_RESET, getpid(), (char)char_leido);
+            if (item.longitud == 1) {
+                printf(ANSI_COLOR_YELLOW "[EMISOR HIJO (PID: %d)] Presiones ENTER para insertar '%c'...\n" ANSI_COLOR_RESET, id_trabajador(), (char)item.datos[0]);
+            } else {
+                printf(ANSI_COLOR_YELLOW "[EMISOR HIJO (PID: %d)] Presiones ENTER para insertar un bloque de %d bytes...\n" ANSI_COLOR_RESET, id_trabajador(), item.longitud);
+            }
             getchar();
         }
 
+        // Lo que se imprime es el primer byte antes y despues de cifrar
+        unsigned char primer_original = item.datos[0];
+        cifrado_aplicar(memoria, &item);
+        unsigned char clave_codificar = primer_original ^ item.datos[0];
+
+        // Se cuenta antes de publicar: un receptor nunca ve consumidos > producidos
+        if (trabajo_rango >= 0) atomic_fetch_add(&tabla->trabajos[trabajo_rango].producidos, item.longitud);
+
         // --- INICIO LOGICA DE BLOQUEO ---
-        if (sem_wait(sem_empty) == -1) {
-            if (errno == EINTR) continue;
-            reportar_error_y_salir("sem_wait (empty)");
+        // Un EINTR no debe perder la unidad ya leida: se reintenta la espera
+        // Para la politica de redimensionado solo cuenta la espera si el buffer estaba lleno de verdad
+        long t_espera = metricas_bloqueo_inicio(metricas);
+        long t_espera_lleno = 0;
+        if (semaforo_intentar(espacio) == -1) {
+            while (semaforo_esperar(espacio) == -1) {
+                if (errno != EINTR) reportar_error_y_salir("sem_wait (empty)");
+            }
+            t_espera_lleno = metricas_ahora_ns() - t_espera;
         }
+        // Con --sync robusto, si muere desde aqui la purga devuelve el espacio tomado
+        sincronizacion_credito(memoria, metricas, SYNC_EMPTY);
+        metricas_bloqueo_fin(metricas, t_espera);
         // --- FIN LOGICA DE BLOQUE ---
 
-        // --- INICIO SECCION CRITICA (ESCRITURA DE BUFFER) ---
-        if (sem_wait(sem_mutex) == -1) {
-            if (errno == EINTR) continue;
-            reportar_error_y_salir("sem_wait (mutex write)");
-        }
-
-        // --- CHEQUEO DE CIERRE (DOBLE) ---
-        if (memoria->shutdown_flag) {
-            sem_post(sem_mutex);
-            sem_post(sem_empty);
-            break;
+        // Marca de encolado: desde aqui se miden las latencias en el receptor
+        item.t_encolado_ns = metricas_ahora_ns();
+
+        if (fragmentado) {
+            // --- CHEQUEO DE CIERRE (DOBLE) ---
+            if (memoria->shutdown_flag) {
+                semaforo_senalar(espacio);
+                break;
+            }
+
+            // --- ENCOLADO EN EL ANILLO PROPIO (UN SOLO PRODUCTOR) ---
+            // Solo falla si un receptor aun esta leyendo la celda: se reintenta
+            while (!fragmento_encolar(memoria, mi_fragmento, &item)) sched_yield();
+            atomic_fetch_add_explicit(&memoria->productores.total_producidos, item.longitud, memory_order_relaxed);
+        } else if (memoria->protocolo_anillo == ANILLO_LOCKFREE) {
+            // --- CHEQUEO DE CIERRE (DOBLE) ---
+            if (memoria->shutdown_flag) {
+                semaforo_senalar(&sync.empty);
+                break;
+            }
+
+            // --- ENCOLADO SIN LOCKS ---
+            // Solo falla si un receptor aun esta liberando la celda: se reintenta
+            while (!anillo_encolar(memoria, &item)) sched_yield();
+            atomic_fetch_add_explicit(&memoria->productores.total_producidos, item.longitud, memory_order_relaxed);
+        } else {
+            // --- INICIO SECCION CRITICA (ESCRITURA DE BUFFER) ---
+            t_espera = metricas_ahora_ns();
+            while (semaforo_esperar(&sync.prod) == -1) {
+                if (errno != EINTR) reportar_error_y_salir("sem_wait (prod write)");
+            }
+            long t_lock = metricas_ahora_ns();
+            metricas_sumar(&metricas->ns_espera_mutex, t_lock - t_espera);
+
+            // --- CHEQUEO DE CIERRE (DOBLE) ---
+            if (memoria->shutdown_flag) {
+                semaforo_senalar(&sync.prod);
+                sincronizacion_credito(memoria, metricas, 0);
+                semaforo_senalar(&sync.empty);
+                break;
+            }
+
+            int indice_escritura_buffer = memoria->productores.idx_escritura;
+            item.indice = indice_escritura_buffer;
+
+            // Con --sync robusto, si este proceso muere aqui el siguiente en tomar sem_prod deshace
+            sincronizacion_deshacer_guardar(memoria, SYNC_PROD, metricas);
+            registro_escribir(memoria, indice_escritura_buffer, &item);
+            memoria->productores.idx_escritura = (indice_escritura_buffer + 1) % memoria->buffer_size;
+            memoria->productores.total_producidos += item.longitud;
+            atomic_store_explicit(&memoria->productores.celdas_escritas,
+                                  atomic_load_explicit(&memoria->productores.celdas_escritas, memory_order_relaxed) + 1,
+                                  memory_order_relaxed);
+            sincronizacion_deshacer_confirmar(memoria, SYNC_PROD, metricas);
+
+            // Con sem_prod tomado, el emisor tambien evalua si el buffer debe crecer o reducirse
+            if (memoria->redimension) redimension_evaluar(memoria, &sync, recursos->shm_fd, t_espera_lleno);
+
+            if (semaforo_senalar(&sync.prod) == -1) reportar_error_y_salir ("sem_post (prod write)");
+            metricas_sumar(&metricas->ns_retencion_mutex, metricas_ahora_ns() - t_lock);
+            // --- FIN SECCION CRITICA (ESCRITURA DE BUFFER) ---
         }
 
-        int indice_escritura_buffer = memoria->idx_escritura;
-
-        struct CharInfo item;
-        item.valor_ascii = (char)char_leido ^ clave_codificar;
-        item.indice = indice_escritura_buffer;
-        item.timestamp = time(NULL);
-
-        memoria->buffer[indice_escritura_buffer] = item;
-        memoria->idx_escritura = (indice_escritura_buffer + 1) % memoria->buffer_size;
-        memoria->total_producidos++;
-
-        if (sem_post(sem_mutex) == -1) reportar_error_y_salir ("sem_post (mutex write)");
-        // --- FIN SECCION CRITICA (ESCRITURA DE BUFFER) ---
-
         // Senalizar que hay un nuevo espacio lleno
-        if (sem_post(sem_full) == -1) reportar_error_y_salir("sem_post (full)");
+        if (fragmentado) {
+            fragmento_publicar(memoria, mi_fragmento);
+        } else {
+            sincronizacion_credito(memoria, metricas, 0);
+            if (semaforo_senalar(&sync.full) == -1) reportar_error_y_salir("sem_post (full)");
+        }
+        metricas_unidad(metricas, item.longitud, ocupacion);
 
         // Imprimir informacion
-        imprimir_produccion(&item, (char)char_leido);
+        if (bitacora != NULL) {
+            bitacora_registrar(bitacora, item.offset_fuente, item.indice, item.longitud,
+                               item.datos[0], item.datos[0] ^ clave_codificar);
+        } else {
+            imprimir_produccion(memoria, &item, clave_codificar);
+        }
     }
 
     // --- Limpieza del proceso hijo ---
+    metricas_terminar(metricas);
     printf(ANSI_COLOR_CYAN  "--------------------------------------------------------------------------------------" ANSI_COLOR_RESET "\n");
 
-    if (sem_wait(sem_mutex) == -1) reportar_error_y_salir("sem_wait (mutex unregister)");
+    if (semaforo_esperar(&sync.mutex) == -1) reportar_error_y_salir("sem_wait (mutex unregister)");
     memoria->emisores_activos--;
     int emisores_vivos = memoria->emisores_activos;
     int receptores_vivos = memoria->receptores_activos;
-    if (sem_post(sem_mutex) == -1 ) reportar_error_y_salir("sem_post (mutex unregister)");
+    if (semaforo_senalar(&sync.mutex) == -1 ) reportar_error_y_salir("sem_post (mutex unregister)");
 
     if (emisores_vivos == 0 && receptores_vivos == 0) {
-        printf(ANSI_COLOR_YELLOW "PID: %d ¡SOY EL ÚLTIMO! Avisando al finalizador.\n" ANSI_COLOR_RESET, getpid());
-        if (sem_post(sem_fin) == -1) reportar_error_y_salir("sem_post (fin)");
+        printf(ANSI_COLOR_YELLOW "PID: %d ¡SOY EL ÚLTIMO! Avisando al finalizador.\n" ANSI_COLOR_RESET, id_trabajador());
+        if (semaforo_senalar(&sync.fin) == -1) reportar_error_y_salir("sem_post (fin)");
     }
 
-    fclose(archivo_fuente);
-    munmap(memoria, total_size);
-    close(shm_fd);
-    sem_close(sem_mutex);
-    sem_close(sem_empty);
-    sem_close(sem_full);
-    sem_close(sem_fin);
+    if (bitacora != NULL) {
+        bitacora_cerrar(bitacora);
+        free(bitacora);
+    }
+    free(item.datos);
+    if (trozo_actual >= 0) flujo_liberar(cola, trozo_actual);
+    if (fuente_compartida == NULL) fuente_cerrar(&fuente);
+}
+
+// Logica principal del emisor - Cada proceso HIJO (creado por fork) ejecutara esta funcion
+void emisor_worker(const char* shm_name, const struct OpcionesEmisor *opciones) {
+    // --- Conectar a los Recursos IPC ---
+    struct RecursosEmisor recursos;
+    recursos_emisor_abrir(&recursos, shm_name);
+
+    emisor_bucle(&recursos, NULL, opciones);
+
+    recursos_emisor_cerrar(&recursos);
     exit(EXIT_SUCCESS);
 }
 
-// Parsea los argumentos - Proceso PADRE que crea N procesos hijos
+// Argumento de cada hilo emisor en el modo --hilos
+struct HiloEmisor {
+    pthread_t hilo;
+    struct RecursosEmisor *recursos;
+    struct FuenteEmisor *fuente;    // Fuente mapeada compartida (NULL = cada hilo abre la suya)
+    const struct OpcionesEmisor *opciones;
+    int indice;                     // Numero de emisor (para la afinidad)
+};
+
+void *emisor_hilo(void *arg) {
+    struct HiloEmisor *h = (struct HiloEmisor *)arg;
+    afinidad_aplicar(&h->opciones->afinidad, h->indice);
+    emisor_bucle(h->recursos, h->fuente, h->opciones);
+    return NULL;
+}
+
+// Modo --hilos: los emisores corren como pthreads que comparten el mapeo, los
+// semaforos y la fuente mapeada; sem_prod pasa a ser privado del proceso.
+void lanzar_hilos(struct RecursosEmisor *recursos, int num_emisores, const struct OpcionesEmisor *opciones) {
+    struct MemoriaCompartida *memoria = recursos->memoria;
+
+    sem_t prod_privado;
+    struct Semaforo prod_original;
+    semaforo_privatizar(&recursos->sync.prod, &prod_privado, 1, &prod_original);
+
+    // Con stdio cada hilo abre su propia fuente (necesita su propia posicion); con flujo
+    // o manifiesto no se abre aqui
+    struct FuenteEmisor fuente;
+    memset(&fuente, 0, sizeof(fuente));
+    if (memoria->modo_lectura != LECTURA_FLUJO && !memoria->manifiesto) fuente_abrir(&fuente, memoria->archivo_fuente, memoria->modo_lectura == LECTURA_MMAP);
+    struct FuenteEmisor *fuente_compartida = (fuente.mapa != NULL) ? &fuente : NULL;
+
+    struct HiloEmisor *hilos = calloc(num_emisores, sizeof(struct HiloEmisor));
+    if (hilos == NULL) reportar_error_y_salir("calloc (hilos)");
+
+    for (int i = 0; i < num_emisores; i++) {
+        hilos[i].recursos = recursos;
+        hilos[i].fuente = fuente_compartida;
+        hilos[i].opciones = opciones;
+        hilos[i].indice = i;
+        int err = pthread_create(&hilos[i].hilo, NULL, emisor_hilo, &hilos[i]);
+        if (err != 0) { errno = err; reportar_error_y_salir("pthread_create"); }
+    }
+
+    for (int i = 0; i < num_emisores; i++) {
+        pthread_join(hilos[i].hilo, NULL);
+        printf(ANSI_COLOR_GREEN "[PADRE (PID: %d)] Hilo %d ha terminado. \n" ANSI_COLOR_RESET, getpid(), i);
+    }
+
+    free(hilos);
+    fuente_cerrar(&fuente);
+    semaforo_restaurar(&recursos->sync.prod, &prod_privado, &prod_original);
+
+    // Los hilos ya no usan el sem_prod privado: otros lanzadores vuelven a ser validos
+    if (semaforo_esperar(&recursos->sync.mutex) == -1) reportar_error_y_salir("Padre: sem_wait (mutex hilos)");
+    memoria->emisores_hilos = 0;
+    if (semaforo_senalar(&recursos->sync.mutex) == -1) reportar_error_y_salir("Padre: sem_post (mutex hilos)");
+}
+
+// Parsea los argumentos - Proceso PADRE que crea N procesos hijos (o N hilos con --hilos)
 int main(int argc, char *argv[]){
     // --- Validar argumentos ---
-    if (argc !=  4) {
-        fprintf(stderr, "Uso: %s <shm_id> <modo (manual|automatico)> <num_emisores>\n", argv[0]);
+    if (argc < 4) {
+        fprintf(stderr, "Uso: %s <shm_id> <modo (manual|automatico)> <num_emisores> [--hilos] [--bitacora <dir>]\n"
+                        "          [--cpus compacta|dispersa|nodo:<N>|<lista>] [--cpu-desde <k>]\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
@@ -222,47 +577,120 @@ int main(int argc, char *argv[]){
     const char* modo_ejecucion = argv[2];
     int num_emisores = atoi(argv[3]);
 
+    // --- Opciones del lanzador ---
+    struct OpcionesEmisor opciones;
+    opciones.modo_manual = 0;
+    opciones.hilos = 0;
+    opciones.dir_bitacora = NULL;
+    opciones.afinidad.politica = AFINIDAD_NINGUNA;
+    opciones.afinidad.desde = 0;
+    for (int i = 4; i < argc; i++) {
+        if (strcmp(argv[i], "--hilos") == 0 || strcmp(argv[i], "--threads") == 0) {
+            opciones.hilos = 1;
+        } else if (strcmp(argv[i], "--bitacora") == 0 && i + 1 < argc) {
+            opciones.dir_bitacora = argv[++i];
+        } else if (strcmp(argv[i], "--cpus") == 0 && i + 1 < argc) {
+            if (afinidad_parsear(&opciones.afinidad, argv[++i]) == -1) {
+                fprintf(stderr, "Error: politica de CPUs invalida '%s'.\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+        } else if (strcmp(argv[i], "--cpu-desde") == 0 && i + 1 < argc) {
+            opciones.afinidad.desde = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Error: opcion desconocida '%s'.\n", argv[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Validar modo
+    if (strcmp(modo_ejecucion, "manual") == 0) {
+        opciones.modo_manual = 1;
+    } else if (strcmp(modo_ejecucion, "automatico") != 0) {
+        fprintf(stderr, "Error: Modo debe ser 'manual' o 'automatico'.\n");
+        exit(EXIT_FAILURE);
+    }
+
     if (num_emisores <= 0) {
         fprintf(stderr, "Error: El numero de emisores debe ser 1 o mas.\n");
         exit(EXIT_FAILURE);
     }
 
+    if (opciones.afinidad.desde < 0) {
+        fprintf(stderr, "Error: --cpu-desde no puede ser negativo.\n");
+        exit(EXIT_FAILURE);
+    }
+
     printf(ANSI_COLOR_GREEN "--- Lanzador de Emisores (PID: %d) ---" ANSI_COLOR_RESET, getpid());
-    printf("Lanzando %d procesos emisores (heavy process)...\n", num_emisores);
+    if (opciones.hilos) {
+        printf("Lanzando %d hilos emisores en un solo proceso...\n", num_emisores);
+    } else {
+        printf("Lanzando %d procesos emisores (heavy process)...\n", num_emisores);
+    }
 
-    // --- Imprimir encabezado de la tabla ---
-    printf("\n" ANSI_COLOR_CYAN "--------------------------------------------------------------------------------------" ANSI_COLOR_RESET "\n");
-    printf(ANSI_COLOR_CYAN "%-20s | %-12s | %-20s | %-8s | %-10s |\n" ANSI_COLOR_RESET,
-           "PROCESO", "ORIGINAL", "CIFRADO (HEX)", "ÍNDICE", "HORA");
-    printf(ANSI_COLOR_CYAN "--------------------------------------------------------------------------------------" ANSI_COLOR_RESET "\n");
+    // Se eligen los kernels de cifrado antes del fork para que los hijos hereden la eleccion
+    cifrado_preparar();
+    printf("Kernels de cifrado: XOR %s, ChaCha20 %s\n", xor_nombre, chacha_nombre);
+
+    // El orden de CPUs se calcula una vez en el padre; cada hijo o hilo toma la suya
+    afinidad_preparar(&opciones.afinidad);
+    afinidad_imprimir(&opciones.afinidad);
+
+    // --- Imprimir encabezado de la tabla (en modo silencioso la imprime logdump) ---
+    if (opciones.dir_bitacora == NULL) {
+        printf("\n" ANSI_COLOR_CYAN "--------------------------------------------------------------------------------------" ANSI_COLOR_RESET "\n");
+        printf(ANSI_COLOR_CYAN "%-20s | %-12s | %-20s | %-8s | %-10s |\n" ANSI_COLOR_RESET,
+               "PROCESO", "ORIGINAL", "CIFRADO (HEX)", "ÍNDICE", "HORA");
+        printf(ANSI_COLOR_CYAN "--------------------------------------------------------------------------------------" ANSI_COLOR_RESET "\n");
+    } else {
+        printf("Modo silencioso: bitacora en %s\n", opciones.dir_bitacora);
+    }
 
     // --- Conectar a SHM y Mutex (SÓLO EL PADRE) ---
-    char sem_mutex_name[512];
-    snprintf(sem_mutex_name, sizeof(sem_mutex_name), "%s%s", shm_name, SEM_MUTEX_NAME_SUFFIX);
-    sem_t *sem_mutex = sem_open(sem_mutex_name, 0);
-    if (sem_mutex == SEM_FAILED) reportar_error_y_salir("Padre: sem_open (mutex)");
-
-    int shm_fd = shm_open(shm_name, O_RDWR, 0666);
-    if (shm_fd == -1) reportar_error_y_salir("Padre: shm_open");
-
-    struct stat shm_stat;
-    if (fstat(shm_fd, &shm_stat) == -1) reportar_error_y_salir("fstat");
-    size_t total_size = shm_stat.st_size;
-    
-    struct MemoriaCompartida *memoria = (struct MemoriaCompartida *)mmap(
-        NULL, total_size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0
-    );
-    if (memoria == MAP_FAILED) reportar_error_y_salir("Padre: mmap");
-    close(shm_fd);
+    struct RecursosEmisor recursos;
+    recursos_emisor_abrir(&recursos, shm_name);
+    struct MemoriaCompartida *memoria = recursos.memoria;
 
     // --- Registrar el total de emisores ---
-    if (sem_wait(sem_mutex) == -1) reportar_error_y_salir("Padre: sem_wait (mutex)");
-    memoria->emisores_totales += num_emisores;
-    if (sem_post(sem_mutex) == -1) reportar_error_y_salir("Padre: sem_post (mutex)");
-    
+    if (semaforo_esperar(&recursos.sync.mutex) == -1) reportar_error_y_salir("Padre: sem_wait (mutex)");
+    // sem_prod solo puede ser privado si no hay emisores de otros lanzadores, y mientras
+    // lo sea ningun otro lanzador puede sumarse (usaria el sem_prod compartido)
+    int otros_emisores = memoria->emisores_totales;
+    int hilos_ajenos = memoria->emisores_hilos;
+    int rechazo_hilos = (opciones.hilos && otros_emisores != 0) || hilos_ajenos;
+    // Con anillos fragmentados cada emisor necesita un anillo propio
+    int sin_anillos = memoria->protocolo_anillo == ANILLO_FRAGMENTADO &&
+                      otros_emisores + num_emisores > memoria->num_fragmentos;
+    if (!rechazo_hilos && !sin_anillos) {
+        memoria->emisores_totales += num_emisores;
+        if (opciones.hilos) memoria->emisores_hilos = 1;
+    }
+    if (semaforo_senalar(&recursos.sync.mutex) == -1) reportar_error_y_salir("Padre: sem_post (mutex)");
+    if (hilos_ajenos) {
+        fprintf(stderr, "Error: ya hay un lanzador de emisores con --hilos; debe ser el unico de su tipo.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (sin_anillos) {
+        fprintf(stderr, "Error: hay %d anillos y ya %d emisores; no alcanzan para %d mas (ver --fragmentos).\n",
+                memoria->num_fragmentos, otros_emisores, num_emisores);
+        exit(EXIT_FAILURE);
+    }
+    if (opciones.hilos && otros_emisores != 0) {
+        fprintf(stderr, "Error: --hilos requiere que este sea el unico lanzador de emisores (ya hay %d).\n", otros_emisores);
+        exit(EXIT_FAILURE);
+    }
+
+    // Vaciar stdout antes del fork para que los hijos no repitan lo ya impreso
+    fflush(stdout);
+
+    if (opciones.hilos) {
+        lanzar_hilos(&recursos, num_emisores, &opciones);
+        recursos_emisor_cerrar(&recursos);
+        printf(ANSI_COLOR_GREEN "--- Emisor (PID: %d): todos los emisores han terminado --- \n" ANSI_COLOR_RESET, getpid());
+        return EXIT_SUCCESS;
+    }
+
     // Desmapear y cerrar semáforo del padre
-    munmap(memoria, total_size);
-    sem_close(sem_mutex);
+    recursos_emisor_cerrar(&recursos);
 
     for (int i = 0; i < num_emisores; i++) {
         pid_t pid = fork();
@@ -274,7 +702,8 @@ int main(int argc, char *argv[]){
             // Heavy process
 
             // Paso de argumentos que el padre parseo
-            emisor_worker(shm_name, modo_ejecucion);
+            afinidad_aplicar(&opciones.afinidad, i);
+            emisor_worker(shm_name, &opciones);
 
             // El hijo termina aqui para no continuar en el bucle 'for' del padre
             exit(EXIT_SUCCESS);
@@ -296,4 +725,4 @@ int main(int argc, char *argv[]){
     printf(ANSI_COLOR_GREEN "--- Emisor (PID: %d): todos los emisores han terminado --- \n" ANSI_COLOR_RESET, getpid());
 
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
@@ -5,9 +5,15 @@
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
-#include <semaphore.h>
 #include <signal.h>     // Para signal() y SIGINT
 #include "memInfo.h"
+#include "sincronizacion.h"
+#include "fragmentos.h"
+#include "latencia.h"
+#include "segmento.h"
+#include "flujo.h"
+#include "trabajos.h"
+#include "checkpoint.h"
 
 #define ANSI_COLOR_RED     "\x1b[31m"
 #define ANSI_COLOR_GREEN   "\x1b[32m"
@@ -28,8 +34,10 @@ void manejador_sigint(int sig) {
 }
 
 int main (int argc, char *argv[]){
-    if (argc != 2) {
-        fprintf(stderr, "Uso: %s <shm_id>\n", argv[0]);
+    // --inmediato: iniciar el cierre sin esperar Ctrl+C (lo usa el benchmark)
+    int cierre_inmediato = argc == 3 && strcmp(argv[2], "--inmediato") == 0;
+    if (argc != 2 && !cierre_inmediato) {
+        fprintf(stderr, "Uso: %s <shm_id> [--inmediato]\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
@@ -37,29 +45,8 @@ int main (int argc, char *argv[]){
 
     printf("Iniciando Finalizador (PID: %d) para SHM: %s\n", getpid(), shm_name);
 
-    // --- Generar Nombres de Semaforos ---
-    char sem_mutex_name[512], sem_empty_name[512], sem_full_name[512], sem_fin_name[512];
-    int r;
-    r = snprintf(sem_mutex_name, sizeof(sem_mutex_name), "%s%s", shm_name, SEM_MUTEX_NAME_SUFFIX);
-    if (r < 0 || (size_t)r >= sizeof(sem_mutex_name)) reportar_error_y_salir("sem name snprintf (mutex) truncated");
-    r = snprintf(sem_empty_name, sizeof(sem_empty_name), "%s%s", shm_name, SEM_EMPTY_NAME_SUFFIX);
-    if (r < 0 || (size_t)r >= sizeof(sem_empty_name)) reportar_error_y_salir("sem name snprintf (empty) truncated");
-    r = snprintf(sem_full_name, sizeof(sem_full_name), "%s%s", shm_name, SEM_FULL_NAME_SUFFIX);
-    if (r < 0 || (size_t)r >= sizeof(sem_full_name)) reportar_error_y_salir("sem name snprintf (full) truncated");
-    r = snprintf(sem_fin_name, sizeof(sem_fin_name), "%s%s", shm_name, SEM_FIN_NAME_SUFFIX);
-    if (r < 0 || (size_t)r >= sizeof(sem_fin_name)) reportar_error_y_salir("sem name snprintf (fin) truncated");
-
     // --- Conectar a los Recursos IPC ---
-    sem_t *sem_mutex = sem_open(sem_mutex_name, 0);
-    if (sem_mutex == SEM_FAILED) reportar_error_y_salir("Error en sem_open (mutex)");
-    sem_t *sem_empty = sem_open(sem_empty_name, 0);
-    if (sem_empty == SEM_FAILED) reportar_error_y_salir("Error en sem_open (empty)");
-    sem_t *sem_full = sem_open(sem_full_name, 0);
-    if (sem_full == SEM_FAILED) reportar_error_y_salir("Error en sem_open (full)");
-    sem_t *sem_fin = sem_open(sem_fin_name, 0);
-    if (sem_fin == SEM_FAILED) reportar_error_y_salir("Error en sem_open (fin)");
-
-    int shm_fd = shm_open(shm_name, O_RDWR, 0666);
+    int shm_fd = segmento_abrir(shm_name, O_RDWR);
     if (shm_fd == -1) reportar_error_y_salir("Error en shm_open");
 
     struct stat shm_stat;
@@ -72,34 +59,73 @@ int main (int argc, char *argv[]){
 
     if (memoria == MAP_FAILED) reportar_error_y_salir("mmap");
 
-    signal(SIGINT, manejador_sigint);
+    struct Sincronizacion sync;
+    sincronizacion_abrir(&sync, shm_name, memoria);
 
-    printf(ANSI_COLOR_GREEN "Finalizador listo. Presione Ctrl+C para iniciar el cierre elegante.\n" ANSI_COLOR_RESET);
+    if (!cierre_inmediato) {
+        signal(SIGINT, manejador_sigint);
 
-    for ( ; shutdown_solicitado == 0 ; ) {
-        pause(); // Duerme el proceso, no gasta CPU.
-    }
+        printf(ANSI_COLOR_GREEN "Finalizador listo. Presione Ctrl+C para iniciar el cierre elegante.\n" ANSI_COLOR_RESET);
+
+        for ( ; shutdown_solicitado == 0 ; ) {
+            pause(); // Duerme el proceso, no gasta CPU.
+        }
 
-    printf(ANSI_COLOR_RED "\n¡Señal Ctrl+C recibida! Iniciando cierre elegante...\n" ANSI_COLOR_RESET);
+        printf(ANSI_COLOR_RED "\n¡Señal Ctrl+C recibida! Iniciando cierre elegante...\n" ANSI_COLOR_RESET);
+    } else {
+        printf(ANSI_COLOR_RED "Cierre inmediato solicitado. Iniciando cierre elegante...\n" ANSI_COLOR_RESET);
+    }
 
     // 1. Activar la bandera de cierre
-    if (sem_wait(sem_mutex) == -1) reportar_error_y_salir("sem_wait (mutex)");
+    if (semaforo_esperar(&sync.mutex) == -1) reportar_error_y_salir("sem_wait (mutex)");
     memoria->shutdown_flag = 1;
     int total_procesos_esperados = memoria->emisores_totales + memoria->receptores_totales;
-    if (sem_post(sem_mutex) == -1) reportar_error_y_salir("sem_post (mutex)");
+    if (semaforo_senalar(&sync.mutex) == -1) reportar_error_y_salir("sem_post (mutex)");
 
     printf("Avisando a %d procesos (emisores y receptores)...\n", total_procesos_esperados);
 
     // 2. Despertar a TODOS los procesos dormidos
     // (Posteamos N veces para asegurarnos de que todos se despierten y vean la bandera)
     for (int i = 0; i < total_procesos_esperados; i++) {
-        if (sem_post(sem_empty) == -1) reportar_error_y_salir("sem_post (spam empty)");
-        if (sem_post(sem_full) == -1) reportar_error_y_salir("sem_post (spam full)");
+        if (semaforo_senalar(&sync.empty) == -1) reportar_error_y_salir("sem_post (spam empty)");
+        if (semaforo_senalar(&sync.full) == -1) reportar_error_y_salir("sem_post (spam full)");
+    }
+    // Con anillos fragmentados los emisores esperan en su anillo y los receptores en el evento
+    if (memoria->protocolo_anillo == ANILLO_FRAGMENTADO) fragmentos_despertar_todos(memoria);
+    // Con --lectura flujo el lector espera trozos libres y los emisores trozos llenos
+    struct ColaTrozos *cola = NULL;
+    size_t tam_cola = 0;
+    if (memoria->modo_lectura == LECTURA_FLUJO) {
+        cola = flujo_abrir(shm_name, &tam_cola);
+        flujo_despertar_todos(cola);
     }
 
+    // Con --manifiesto solo se lee la tabla para el resumen
+    struct TablaTrabajos *tabla = NULL;
+    size_t tam_tabla = 0;
+    if (memoria->manifiesto) tabla = trabajos_abrir(shm_name, &tam_tabla);
+
+    // Con --checkpoint solo se lee la marca para el resumen (el ultimo receptor ya la guardo)
+    struct Checkpoint *cp = NULL;
+    size_t tam_cp = 0;
+    if (memoria->checkpoint) cp = checkpoint_abrir(shm_name, &tam_cp);
+
     // 3. Esperar a que el ÚLTIMO proceso nos avise (SIN BUSY WAITING)
     printf("Esperando a que el último proceso termine...\n");
-    if (sem_wait(sem_fin) == -1) reportar_error_y_salir("sem_wait (fin)");
+    // Con --sync robusto un trabajador muerto no avisaria nunca: cada tanto se dan de
+    // baja los muertos y, si no queda nadie vivo, no hay a quien esperar
+    int recuperaciones = 0;
+    while (semaforo_esperar_plazo(&sync.fin, 500) == -1) {
+        if (errno != ETIMEDOUT) reportar_error_y_salir("sem_wait (fin)");
+        if (semaforo_esperar(&sync.mutex) == -1) reportar_error_y_salir("sem_wait (mutex purga)");
+        sincronizacion_purgar_muertos(memoria);
+        int vivos = memoria->emisores_activos + memoria->receptores_activos;
+        if (semaforo_senalar(&sync.mutex) == -1) reportar_error_y_salir("sem_post (mutex purga)");
+        if (vivos == 0) break;
+    }
+    if (memoria->backend_sync == SYNC_ROBUSTO) {
+        for (int i = 0; i < SYNC_TOTAL; i++) recuperaciones += atomic_load(&memoria->sync_robusto[i].recuperaciones);
+    }
     
     printf(ANSI_COLOR_GREEN "\n¡Todos los procesos han terminado!\n" ANSI_COLOR_RESET);
 
@@ -109,13 +135,96 @@ int main (int argc, char *argv[]){
     printf("===============================================\n");
     printf("Memoria Compartida ID: \t%s\n", shm_name);
     printf("Tamaño Total de Memoria: \t%ld bytes\n", total_size);
+    printf("Paginas del Segmento: \t\t%s, %ld KiB%s\n",
+           memoria->tipo_paginas == PAGINAS_HUGETLB ? "hugetlbfs" :
+           memoria->tipo_paginas == PAGINAS_THP ? "THP" : "normales",
+           memoria->tam_pagina / 1024, memoria->prefault ? " (prefault)" : "");
     printf("-----------------------------------------------\n");
-    printf("Caracteres Producidos (Total): \t%d\n", memoria->total_producidos);
-    printf("Caracteres Consumidos (Total): \t%d\n", memoria->total_consumidos);
-    printf("Caracteres en Buffer (Final): \t%d\n", memoria->total_producidos - memoria->total_consumidos);
+    // Densidad: bytes de caracteres transportables frente a bytes que ocupa el buffer
+    size_t bytes_buffer = (size_t)memoria->buffer_size * memoria->tam_registro;
+    size_t carga_buffer = (size_t)memoria->buffer_size * memoria->tam_bloque;
+    printf("Formato de Registro: \t\t%s (%d bytes)\n",
+           memoria->formato_registro == REGISTRO_BLOQUE ? "bloque" :
+           memoria->formato_registro == REGISTRO_COMPACTO ? "compacto" : "completo", memoria->tam_registro);
+    printf("Cifrado: \t\t\t%s\n", memoria->algoritmo_cifrado == CIFRADO_CHACHA20 ? "chacha20" : "xor");
+    printf("Orden de Salida: \t\t%s\n", memoria->orden_salida == ORDEN_FUENTE ? "fuente" : "llegada");
+    printf("Buffer (Carga / Ocupado): \t%zu / %zu bytes\n", carga_buffer, bytes_buffer);
+    printf("Densidad de Carga Útil: \t%.2f%%\n", 100.0 * carga_buffer / bytes_buffer);
+    if (memoria->redimension) {
+        printf("Buffer Redimensionable: \t%d (rango %d..%d), generacion %d\n", memoria->buffer_size,
+               memoria->buffer_min, memoria->buffer_max, atomic_load(&memoria->generacion));
+        printf("Crecimientos / Reducciones: \t%d / %d\n", memoria->veces_crecido, memoria->veces_reducido);
+    }
+    if (memoria->protocolo_anillo == ANILLO_FRAGMENTADO) {
+        printf("-----------------------------------------------\n");
+        printf("Anillos Fragmentados: \t\t%d x %d espacios\n", memoria->num_fragmentos, memoria->celdas_fragmento);
+        for (int f = 0; f < memoria->num_fragmentos; f++) {
+            struct Fragmento *frag = fragmento(memoria, f);
+            long unidades = atomic_load(&frag->unidades);
+            long robadas = atomic_load(&frag->robadas);
+            printf("  Anillo %-3d Unidades: %-10ld Robadas: %ld (%.1f%%)\n", f, unidades, robadas,
+                   unidades > 0 ? 100.0 * robadas / unidades : 0.0);
+        }
+    }
+    if (cola != NULL) {
+        printf("-----------------------------------------------\n");
+        printf("Lectura en Flujo: \t\t%d trozos de %d bytes\n", cola->num_trozos, cola->tam_trozo);
+        printf("Bytes Leidos por el Lector: \t%ld%s\n", atomic_load(&cola->bytes_leidos),
+               atomic_load(&cola->fin_flujo) ? " (fuente completa)" : "");
+        printf("Espera Lector / Emisores: \t%.3f s (cola llena) / %.3f s (cola vacia)\n",
+               atomic_load(&cola->ns_esperando_libre) / 1e9, atomic_load(&cola->ns_esperando_lleno) / 1e9);
+    }
+    if (tabla != NULL) {
+        printf("-----------------------------------------------\n");
+        printf("Trabajos Completos: \t\t%d / %d\n", atomic_load(&tabla->trabajos_completos), tabla->num_trabajos);
+        int listados = 0;
+        for (int i = 0; i < tabla->num_trabajos; i++) {
+            struct Trabajo *t = &tabla->trabajos[i];
+            int estado = atomic_load(&t->estado);
+            if (estado == TRABAJO_COMPLETO) continue;
+            if (listados++ == 10) {
+                printf("  ...\n");
+                break;
+            }
+            printf("  %-3d %s: %s, %ld / %ld bytes leidos\n", i, t->fuente,
+                   estado == TRABAJO_PENDIENTE ? "pendiente" : estado == TRABAJO_EN_CURSO ? "en curso" : "sin consumir",
+                   t->idx_lectura, t->tam);
+        }
+    }
+    if (cp != NULL) {
+        printf("-----------------------------------------------\n");
+        printf("Checkpoint: \t\t\t%s (%ld guardados)\n", cp->ruta, atomic_load(&cp->guardados));
+        printf("Escrito Entero (Marca): \t%ld / %ld bytes%s\n", checkpoint_escrito(cp), cp->tam_fuente,
+               checkpoint_escrito(cp) == cp->tam_fuente ? " (fuente completa)" : "");
+        if (cp->reanudado_desde > 0) printf("Reanudado Desde: \t\t%ld bytes\n", cp->reanudado_desde);
+    }
+    printf("-----------------------------------------------\n");
+    printf("Caracteres Producidos (Total): \t%ld\n", memoria->productores.total_producidos);
+    printf("Caracteres Consumidos (Total): \t%ld\n", memoria->consumidores.total_consumidos);
+    printf("Caracteres en Buffer (Final): \t%ld\n", memoria->productores.total_producidos - memoria->consumidores.total_consumidos);
     printf("-----------------------------------------------\n");
     printf("Emisores (Vivos / Totales): \t%d / %d\n", memoria->emisores_activos, memoria->emisores_totales);
     printf("Receptores (Vivos / Totales): \t%d / %d\n", memoria->receptores_activos, memoria->receptores_totales);
+    if (memoria->backend_sync == SYNC_ROBUSTO) {
+        printf("Locks Recuperados (EOWNERDEAD): %d\n", recuperaciones);
+        printf("Trabajadores Muertos Purgados: \t%d\n", memoria->trabajadores_purgados);
+    }
+    printf("-----------------------------------------------\n");
+    // Latencias desde la marca de encolado: por receptor y combinadas
+    printf(ANSI_COLOR_YELLOW "Latencias (encolado -> desencolado / -> escritura):\n" ANSI_COLOR_RESET);
+    static struct LatenciaReceptor combinada;
+    for (int i = 0; i < MAX_RECEPTORES_LATENCIA; i++) {
+        const struct LatenciaReceptor *l = &memoria->latencias[i];
+        if (l->pid == 0) continue;
+        printf("Receptor PID %d:\n", l->pid);
+        latencia_imprimir("encolado->desencolado", &l->desencolado);
+        latencia_imprimir("encolado->escritura", &l->escritura);
+        latencia_sumar(&combinada.desencolado, &l->desencolado);
+        latencia_sumar(&combinada.escritura, &l->escritura);
+    }
+    printf("Todos los receptores:\n");
+    latencia_imprimir("encolado->desencolado", &combinada.desencolado);
+    latencia_imprimir("encolado->escritura", &combinada.escritura);
     printf("===============================================\n");
 
     // --- Limpieza Final de Recursos ---
@@ -123,17 +232,23 @@ int main (int argc, char *argv[]){
     munmap(memoria, total_size);
     close(shm_fd);
     
-    sem_close(sem_mutex);
-    sem_close(sem_empty);
-    sem_close(sem_full);
-    sem_close(sem_fin);
+    sincronizacion_cerrar(&sync);
 
     // ¡El finalizador es el responsable de borrar todo!
-    shm_unlink(shm_name);
-    sem_unlink(sem_mutex_name);
-    sem_unlink(sem_empty_name);
-    sem_unlink(sem_full_name);
-    sem_unlink(sem_fin_name);
+    segmento_eliminar(shm_name);
+    sincronizacion_eliminar(shm_name);
+    if (cola != NULL) {
+        flujo_cerrar(cola, tam_cola);
+        flujo_eliminar(shm_name);
+    }
+    if (tabla != NULL) {
+        trabajos_cerrar(tabla, tam_tabla);
+        trabajos_eliminar(shm_name);
+    }
+    if (cp != NULL) {
+        checkpoint_cerrar(cp, tam_cp);
+        checkpoint_eliminar(shm_name);
+    }
 
     printf(ANSI_COLOR_GREEN "Sistema finalizado limpiamente. ¡Adiós!\n" ANSI_COLOR_RESET);
     return EXIT_SUCCESS;
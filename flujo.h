@@ -0,0 +1,207 @@
+#ifndef FLUJO_H
+#define FLUJO_H
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>          // Para O_CREAT, O_RDWR
+#include <unistd.h>         // Para ftruncate, close
+#include <sched.h>          // Para sched_yield
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "memInfo.h"
+#include "sincronizacion.h"
+#include "metricas.h"
+
+// Modo LECTURA_FLUJO: un unico proceso lector (lector.c) lee la fuente de forma
+// secuencial, en trozos grandes, y los deja en una cola de trozos; los emisores
+// ya no abren la fuente, solo toman trozos, cifran y encolan. Asi la fuente puede
+// ser stdin, una FIFO o un archivo de cualquier tamano, y se lee una sola vez.
+//
+// La cola vive en su propio segmento <shm_id>_trozos (no depende de la geometria
+// del buffer): una cabecera struct ColaTrozos, num_trozos cabeceras struct Trozo
+// y luego los datos, tam_trozo bytes por trozo.
+//
+// Protocolo (un productor, varios consumidores):
+//   lector:  espera 'libres', espera a que el trozo pos % K quede libre (secuencia == pos),
+//            lo llena, publica secuencia = pos + 1 y trozos_publicados, y senala 'llenos'
+//   emisor:  espera 'llenos', toma pos con fetch_add; si pos < trozos_publicados el trozo
+//            es suyo, si no el flujo termino. Al terminar el trozo lo libera (secuencia
+//            = pos + K) y senala 'libres'.
+// Al llegar al fin de la fuente el lector marca fin_flujo y senala 'llenos' una vez
+// mas; cada emisor que lo recibe sin trozo lo vuelve a senalar para el siguiente.
+
+struct Trozo {
+    _Alignas(TAM_LINEA_CACHE) _Atomic unsigned long secuencia;
+    long offset_fuente;             // Posicion en la fuente de su primer byte
+    int longitud;                   // Bytes validos
+};
+
+struct ColaTrozos {
+    // --- Configuracion (la escribe el inicializador) ---
+    int num_trozos;
+    int tam_trozo;
+
+    // --- Lado del lector ---
+    _Alignas(TAM_LINEA_CACHE) _Atomic unsigned long trozos_publicados;
+    _Atomic int fin_flujo;          // 1 = el lector llego al fin de la fuente
+    _Atomic int lector_activo;      // Hay un lector conectado (solo puede haber uno)
+    _Atomic long bytes_leidos;
+    _Atomic long ns_esperando_libre;    // Tiempo del lector con la cola llena (emisores lentos)
+    struct SemFutex libres;         // Trozos vacios: solo espera el lector
+
+    // --- Lado de los emisores ---
+    _Alignas(TAM_LINEA_CACHE) _Atomic unsigned long pos_tomar;
+    _Atomic long ns_esperando_lleno;    // Tiempo de los emisores con la cola vacia (lector lento)
+    struct SemFutex llenos;         // Trozos listos (y el aviso de fin)
+
+    struct Trozo trozos[];
+};
+
+static inline size_t flujo_tam_segmento(int num_trozos, int tam_trozo) {
+    return sizeof(struct ColaTrozos) + (size_t)num_trozos * sizeof(struct Trozo) + (size_t)num_trozos * tam_trozo;
+}
+
+static inline unsigned char *flujo_datos(struct ColaTrozos *cola, unsigned long pos) {
+    unsigned char *datos = (unsigned char *)&cola->trozos[cola->num_trozos];
+    return datos + (pos % cola->num_trozos) * (size_t)cola->tam_trozo;
+}
+
+static inline struct Trozo *flujo_trozo(struct ColaTrozos *cola, unsigned long pos) {
+    return &cola->trozos[pos % cola->num_trozos];
+}
+
+static inline void flujo_nombre(char *destino, size_t tam, const char *shm_name) {
+    sincronizacion_nombre(destino, tam, shm_name, SHM_TROZOS_NAME_SUFFIX);
+}
+
+// Inicializador: crea la cola vacia. Devuelve el segmento mapeado (tamano en *tam).
+static inline struct ColaTrozos *flujo_crear(const char *shm_name, int num_trozos, int tam_trozo,
+                                             int presupuesto_espera, size_t *tam) {
+    char nombre[512];
+    flujo_nombre(nombre, sizeof(nombre), shm_name);
+    int fd = shm_open(nombre, O_CREAT | O_RDWR, 0666);
+    if (fd == -1) reportar_error_y_salir("shm_open (trozos)");
+    *tam = flujo_tam_segmento(num_trozos, tam_trozo);
+    if (ftruncate(fd, *tam) == -1) reportar_error_y_salir("ftruncate (trozos)");
+    struct ColaTrozos *cola = mmap(NULL, *tam, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (cola == MAP_FAILED) reportar_error_y_salir("mmap (trozos)");
+    close(fd);
+
+    cola->num_trozos = num_trozos;
+    cola->tam_trozo = tam_trozo;
+    atomic_init(&cola->trozos_publicados, 0);
+    atomic_init(&cola->fin_flujo, 0);
+    atomic_init(&cola->lector_activo, 0);
+    atomic_init(&cola->bytes_leidos, 0);
+    atomic_init(&cola->ns_esperando_libre, 0);
+    atomic_init(&cola->pos_tomar, 0);
+    atomic_init(&cola->ns_esperando_lleno, 0);
+    atomic_init(&cola->libres.valor, num_trozos);
+    atomic_init(&cola->libres.esperando, 0);
+    atomic_init(&cola->libres.giro_adaptativo, presupuesto_espera);
+    atomic_init(&cola->llenos.valor, 0);
+    atomic_init(&cola->llenos.esperando, 0);
+    atomic_init(&cola->llenos.giro_adaptativo, presupuesto_espera);
+    for (int i = 0; i < num_trozos; i++) {
+        atomic_init(&cola->trozos[i].secuencia, (unsigned long)i);
+        cola->trozos[i].offset_fuente = 0;
+        cola->trozos[i].longitud = 0;
+    }
+    return cola;
+}
+
+// Lector, emisores y finalizador: se conectan a la cola ya creada
+static inline struct ColaTrozos *flujo_abrir(const char *shm_name, size_t *tam) {
+    char nombre[512];
+    flujo_nombre(nombre, sizeof(nombre), shm_name);
+    int fd = shm_open(nombre, O_RDWR, 0666);
+    if (fd == -1) reportar_error_y_salir("shm_open (trozos)");
+    struct stat info;
+    if (fstat(fd, &info) == -1) reportar_error_y_salir("fstat (trozos)");
+    *tam = info.st_size;
+    struct ColaTrozos *cola = mmap(NULL, *tam, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (cola == MAP_FAILED) reportar_error_y_salir("mmap (trozos)");
+    close(fd);
+    return cola;
+}
+
+static inline void flujo_cerrar(struct ColaTrozos *cola, size_t tam) {
+    munmap(cola, tam);
+}
+
+// Borra el segmento de la cola (no falla si no existe)
+static inline void flujo_eliminar(const char *shm_name) {
+    char nombre[512];
+    flujo_nombre(nombre, sizeof(nombre), shm_name);
+    shm_unlink(nombre);
+}
+
+// --- Lado del lector ---
+
+// Espera un trozo libre para la posicion 'pos'. Devuelve sus datos o NULL si hubo cierre.
+static inline unsigned char *flujo_reservar(struct ColaTrozos *cola, unsigned long pos,
+                                            volatile int *shutdown_flag, int presupuesto_espera) {
+    long t_espera = metricas_ahora_ns();
+    while (sem_futex_esperar(&cola->libres, presupuesto_espera) == -1) {
+        if (errno != EINTR) reportar_error_y_salir("futex (trozos libres)");
+    }
+    // Un emisor lento puede tener aun este trozo aunque otro ya haya liberado el suyo
+    struct Trozo *trozo = flujo_trozo(cola, pos);
+    while (atomic_load_explicit(&trozo->secuencia, memory_order_acquire) != pos) {
+        if (*shutdown_flag) return NULL;
+        sched_yield();
+    }
+    atomic_fetch_add_explicit(&cola->ns_esperando_libre, metricas_ahora_ns() - t_espera, memory_order_relaxed);
+    if (*shutdown_flag) return NULL;
+    return flujo_datos(cola, pos);
+}
+
+static inline void flujo_publicar(struct ColaTrozos *cola, unsigned long pos, long offset_fuente, int longitud) {
+    struct Trozo *trozo = flujo_trozo(cola, pos);
+    trozo->offset_fuente = offset_fuente;
+    trozo->longitud = longitud;
+    atomic_store_explicit(&trozo->secuencia, pos + 1, memory_order_release);
+    atomic_store_explicit(&cola->trozos_publicados, pos + 1, memory_order_release);
+    atomic_fetch_add_explicit(&cola->bytes_leidos, longitud, memory_order_relaxed);
+    sem_futex_senalar(&cola->llenos);
+}
+
+static inline void flujo_terminar(struct ColaTrozos *cola) {
+    atomic_store(&cola->fin_flujo, 1);
+    sem_futex_senalar(&cola->llenos);
+}
+
+// --- Lado de los emisores ---
+
+// Toma el proximo trozo. Devuelve su posicion, o -1 si el flujo termino o hubo cierre.
+static inline long flujo_tomar(struct ColaTrozos *cola, volatile int *shutdown_flag, int presupuesto_espera) {
+    long t_espera = metricas_ahora_ns();
+    while (sem_futex_esperar(&cola->llenos, presupuesto_espera) == -1) {
+        if (errno != EINTR) reportar_error_y_salir("futex (trozos llenos)");
+    }
+    atomic_fetch_add_explicit(&cola->ns_esperando_lleno, metricas_ahora_ns() - t_espera, memory_order_relaxed);
+
+    unsigned long pos = atomic_fetch_add(&cola->pos_tomar, 1);
+    if (*shutdown_flag || pos >= atomic_load_explicit(&cola->trozos_publicados, memory_order_acquire)) {
+        // Sin trozo: fin del flujo (o cierre). El aviso pasa al siguiente emisor.
+        sem_futex_senalar(&cola->llenos);
+        return -1;
+    }
+    // El lector publica en orden: si pos < trozos_publicados el trozo ya esta listo
+    return (long)pos;
+}
+
+static inline void flujo_liberar(struct ColaTrozos *cola, unsigned long pos) {
+    atomic_store_explicit(&flujo_trozo(cola, pos)->secuencia, pos + cola->num_trozos, memory_order_release);
+    sem_futex_senalar(&cola->libres);
+}
+
+// Finalizador: despierta al lector y a los emisores que esperan en la cola
+static inline void flujo_despertar_todos(struct ColaTrozos *cola) {
+    sem_futex_senalar(&cola->libres);
+    sem_futex_senalar(&cola->llenos);
+}
+
+#endif // FLUJO_H
@@ -0,0 +1,181 @@
+#ifndef FRAGMENTOS_H
+#define FRAGMENTOS_H
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "memInfo.h"
+#include "registro.h"
+#include "anillo.h"
+#include "sincronizacion.h"
+
+// Topologia ANILLO_FRAGMENTADO: el buffer se parte en num_fragmentos anillos de
+// celdas_fragmento celdas, y cada emisor es el unico productor de uno de ellos.
+// El emisor encola sin CAS ni lock (solo espera en los 'libres' de su anillo);
+// cada receptor vacia primero su anillo de casa y, si esta vacio, roba de los
+// demas. Los receptores compiten con CAS solo dentro de un mismo anillo y,
+// cuando no hay nada en ninguno, duermen en memoria->evento_fragmentos.
+//
+// Las celdas usan los mismos numeros de secuencia que anillo.h (la celda
+// global f * celdas_fragmento + i), seguidos de las cabeceras struct Fragmento.
+
+// Las cabeceras van tras las secuencias, alineadas a linea de cache. El desplazamiento
+// es relativo a memoria->buffer, que ya esta alineado.
+static inline size_t fragmentos_desplazamiento(int buffer_size, int tam_registro) {
+    size_t fin_secuencias = (size_t)buffer_size * tam_registro + anillo_tam_extra(buffer_size);
+    return (fin_secuencias + TAM_LINEA_CACHE - 1) & ~(size_t)(TAM_LINEA_CACHE - 1);
+}
+
+// Bytes extra (ademas de las celdas) que necesita el segmento: secuencias, relleno y cabeceras
+static inline size_t fragmentos_tam_extra(int buffer_size, int tam_registro, int num_fragmentos) {
+    return fragmentos_desplazamiento(buffer_size, tam_registro) - (size_t)buffer_size * tam_registro
+           + (size_t)num_fragmentos * sizeof(struct Fragmento);
+}
+
+static inline struct Fragmento *fragmento(struct MemoriaCompartida *memoria, int f) {
+    unsigned char *cabeceras = memoria->buffer + fragmentos_desplazamiento(memoria->buffer_size, memoria->tam_registro);
+    return (struct Fragmento *)cabeceras + f;
+}
+
+static inline void fragmentos_inicializar(struct MemoriaCompartida *memoria) {
+    _Atomic unsigned long *secuencias = anillo_secuencias(memoria);
+    for (int f = 0; f < memoria->num_fragmentos; f++) {
+        struct Fragmento *frag = fragmento(memoria, f);
+        for (int i = 0; i < memoria->celdas_fragmento; i++) {
+            atomic_init(&secuencias[f * memoria->celdas_fragmento + i], (unsigned long)i);
+        }
+        frag->pos_encolar = 0;
+        atomic_init(&frag->unidades, 0);
+        atomic_init(&frag->pos_desencolar, 0);
+        atomic_init(&frag->robadas, 0);
+        atomic_init(&frag->libres.valor, memoria->celdas_fragmento);
+        atomic_init(&frag->libres.esperando, 0);
+        atomic_init(&frag->libres.giro_adaptativo, memoria->presupuesto_espera);
+        atomic_init(&frag->llenos.valor, 0);
+        atomic_init(&frag->llenos.esperando, 0);
+        atomic_init(&frag->llenos.giro_adaptativo, 0);
+    }
+    atomic_init(&memoria->evento_fragmentos.secuencia, 0);
+    atomic_init(&memoria->evento_fragmentos.dormidos, 0);
+    atomic_init(&memoria->productores.fragmentos_asignados, 0);
+    atomic_init(&memoria->consumidores.casas_asignadas, 0);
+}
+
+// Envuelve un contador de un anillo como struct Semaforo (para esperar y para las metricas)
+static inline struct Semaforo fragmento_semaforo(struct MemoriaCompartida *memoria, struct SemFutex *contador) {
+    struct Semaforo s;
+    s.sem = NULL;
+    s.futex = contador;
+    s.presupuesto_espera = memoria->presupuesto_espera;
+    return s;
+}
+
+// --- Lado del emisor dueno (un solo productor: sin CAS) ---
+
+// Escribe el item en la proxima celda del anillo 'f'. Devuelve 0 si un receptor
+// aun esta leyendo esa celda (ya tomo su lugar en 'libres' pero no termino).
+static inline int fragmento_encolar(struct MemoriaCompartida *memoria, int f, struct Bloque *item) {
+    struct Fragmento *frag = fragmento(memoria, f);
+    unsigned long n = (unsigned long)memoria->celdas_fragmento;
+    unsigned long pos = frag->pos_encolar;
+    int celda = f * memoria->celdas_fragmento + (int)(pos % n);
+    _Atomic unsigned long *secuencia = &anillo_secuencias(memoria)[celda];
+
+    if (atomic_load_explicit(secuencia, memory_order_acquire) != pos) return 0;
+
+    item->indice = celda;
+    registro_escribir(memoria, celda, item);
+    atomic_store_explicit(secuencia, pos + 1, memory_order_release);
+    frag->pos_encolar = pos + 1;
+    atomic_fetch_add_explicit(&frag->unidades, 1, memory_order_relaxed);
+    return 1;
+}
+
+// Cuenta la celda recien publicada y despierta a un receptor si alguno duerme
+static inline void fragmento_publicar(struct MemoriaCompartida *memoria, int f) {
+    atomic_fetch_add(&fragmento(memoria, f)->llenos.valor, 1);
+    struct EventoFutex *evento = &memoria->evento_fragmentos;
+    if (atomic_load(&evento->dormidos) > 0) {
+        atomic_fetch_add(&evento->secuencia, 1);
+        futex_despertar(&evento->secuencia, 1);
+    }
+}
+
+// --- Lado de los receptores (varios consumidores por anillo) ---
+
+// Saca el item mas antiguo del anillo 'f' si hay alguno publicado y sin duenio
+static inline int fragmento_desencolar(struct MemoriaCompartida *memoria, int f, struct Bloque *item) {
+    struct Fragmento *frag = fragmento(memoria, f);
+    if (!sem_futex_intentar(&frag->llenos)) return 0;
+
+    // Se reservo una celda llena: la mas antigua sin reclamar ya esta publicada
+    _Atomic unsigned long *secuencias = anillo_secuencias(memoria) + (size_t)f * memoria->celdas_fragmento;
+    unsigned long n = (unsigned long)memoria->celdas_fragmento;
+    unsigned long pos = atomic_load_explicit(&frag->pos_desencolar, memory_order_relaxed);
+    for (;;) {
+        unsigned long seq = atomic_load_explicit(&secuencias[pos % n], memory_order_acquire);
+        if (seq == pos + 1 &&
+            atomic_compare_exchange_weak_explicit(&frag->pos_desencolar, &pos, pos + 1,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+            break;
+        }
+        if (seq != pos + 1) {
+            PAUSA_CPU();
+            pos = atomic_load_explicit(&frag->pos_desencolar, memory_order_relaxed);
+        }
+    }
+
+    registro_leer(memoria, f * memoria->celdas_fragmento + (int)(pos % n), item);
+    atomic_store_explicit(&secuencias[pos % n], pos + n, memory_order_release);
+    return 1;
+}
+
+// Recorre los anillos empezando por el de casa. Devuelve el anillo de donde salio el item o -1.
+static inline int fragmentos_intentar(struct MemoriaCompartida *memoria, int casa, struct Bloque *item) {
+    int k = memoria->num_fragmentos;
+    for (int i = 0; i < k; i++) {
+        int f = (casa + i) % k;
+        if (fragmento_desencolar(memoria, f, item)) {
+            if (f != casa) atomic_fetch_add_explicit(&fragmento(memoria, f)->robadas, 1, memory_order_relaxed);
+            return f;
+        }
+    }
+    return -1;
+}
+
+// Toma el proximo item de cualquier anillo: gira hasta presupuesto_espera vueltas
+// y luego duerme en el evento. Devuelve el anillo de origen o -1 si hubo cierre.
+static inline int fragmentos_tomar(struct MemoriaCompartida *memoria, int casa, struct Bloque *item) {
+    struct EventoFutex *evento = &memoria->evento_fragmentos;
+    for (;;) {
+        // Igual que con sem_full: tras el cierre no se toma nada mas, aunque quede en los anillos
+        if (memoria->shutdown_flag) return -1;
+        for (int giro = 0; giro <= memoria->presupuesto_espera; giro++) {
+            int f = fragmentos_intentar(memoria, casa, item);
+            if (f >= 0) return f;
+            PAUSA_CPU();
+        }
+
+        // Anunciarse y volver a mirar: un emisor que publique despues vera dormidos > 0
+        atomic_fetch_add(&evento->dormidos, 1);
+        int secuencia = atomic_load(&evento->secuencia);
+        int f = fragmentos_intentar(memoria, casa, item);
+        if (f < 0 && !memoria->shutdown_flag) futex_esperar(&evento->secuencia, secuencia);
+        atomic_fetch_sub(&evento->dormidos, 1);
+        if (f >= 0) return f;
+    }
+}
+
+// El receptor devuelve la celda al emisor dueno del anillo
+static inline int fragmento_liberar(struct MemoriaCompartida *memoria, int f) {
+    return sem_futex_senalar(&fragmento(memoria, f)->libres);
+}
+
+// Finalizador: despierta a los emisores que esperan celdas y a los receptores dormidos
+static inline void fragmentos_despertar_todos(struct MemoriaCompartida *memoria) {
+    for (int f = 0; f < memoria->num_fragmentos; f++) fragmento_liberar(memoria, f);
+    atomic_fetch_add(&memoria->evento_fragmentos.secuencia, 1);
+    futex_despertar(&memoria->evento_fragmentos.secuencia, INT_MAX);
+}
+
+#endif // FRAGMENTOS_H
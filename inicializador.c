@@ -1,3 +1,4 @@
+#define _GNU_SOURCE     // Para cpu_set_t (afinidad.h)
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -6,7 +7,19 @@
 #include <sys/mman.h>  // Para shm_opne, mmap
 #include <sys/stat.h>  // Para modos (0666)
 #include <semaphore.h> // Para sem_open, sem_close
+#include <sys/random.h> // Para getrandom (clave y nonce de ChaCha20)
 #include "memInfo.h"   // Archivo de cabecera
+#include "registro.h"  // Formato de las celdas del buffer
+#include "anillo.h"    // Anillo sin locks
+#include "fragmentos.h" // Un anillo por emisor con robo entre receptores
+#include "sincronizacion.h" // Semaforos POSIX o futex
+#include "afinidad.h"   // Enlace del segmento a un nodo NUMA
+#include "segmento.h"   // Paginas grandes y prefault del segmento
+#include "redimension.h" // Buffer que crece y se reduce en linea
+#include "flujo.h"      // Cola de trozos de --lectura flujo
+#include "trabajos.h"   // Tabla de trabajos de --manifiesto
+#include "cifrado.h"    // Algoritmos de cifrado
+#include "checkpoint.h" // Marca de lo escrito y reanudacion
 
 // Funcion para imprimir errores y salir
 void reportar_error_y_salir(const char *msg) {
@@ -14,6 +27,16 @@ void reportar_error_y_salir(const char *msg) {
     exit(EXIT_FAILURE);
 }
 
+// Muestra las opciones aceptadas por el inicializador y termina
+void imprimir_uso_y_salir(const char *programa) {
+    fprintf(stderr, "Uso: %s [--reclamo <bytes>] [--lectura mmap|stdio|flujo] [--trozo <bytes>] [--trozos <n>] [--anillo semaforos|lockfree|fragmentado] [--fragmentos <K>] [--registro completo|compacto|bloque] [--bloque <bytes>]\n"
+                    "          [--orden llegada|fuente] [--cifrado xor|chacha20] [--clave <64 hex>] [--sync semaforos|futex|robusto] [--espera <vueltas>] [--numa <nodo>]\n"
+                    "          [--paginas normales|thp|hugetlb] [--prefault] [--buffer-max <espacios>] [--buffer-min <espacios>]\n"
+                    "          [--checkpoint <archivo> [--checkpoint-cada <ms>] [--checkpoint-granulo <bytes>] [--reanudar]]\n"
+                    "          [--id <shm_id>] [--buffer <espacios>] [--llave <0-255>] [--fuente <archivo> | --manifiesto <archivo>]\n", programa);
+    exit(EXIT_FAILURE);
+}
+
 // Funcion auxiliar para leer una linea de forma segura y quitar el newline
 void leer_linea(char *buffer, int size) {
     if (fgets(buffer, size, stdin) != NULL) {
@@ -31,25 +54,183 @@ int main(int argc, char *argv[]) {
     int buffer_size;
     char llave_str[10];
     int llave_num;
+    int tam_reclamo = TAM_RECLAMO_DEFECTO;
+    int modo_lectura = LECTURA_MMAP;
+    int tam_trozo = TAM_TROZO_DEFECTO;
+    int num_trozos = TROZOS_DEFECTO;
+    int protocolo_anillo = ANILLO_SEMAFOROS;
+    int num_fragmentos = FRAGMENTOS_DEFECTO;
+    int formato_registro = REGISTRO_COMPLETO;
+    int orden_salida = ORDEN_LLEGADA;
+    int algoritmo_cifrado = CIFRADO_XOR;
+    const char *clave_hex = NULL;   // Clave de ChaCha20 (NULL = aleatoria)
+    const char *ruta_checkpoint = NULL;     // Archivo lateral con la marca de lo escrito
+    long checkpoint_cada = CHECKPOINT_CADA_DEFECTO;
+    long granulo_checkpoint = CHECKPOINT_GRANULO_DEFECTO;
+    int reanudar = 0;
+    int tam_bloque = TAM_BLOQUE_DEFECTO;
+    int backend_sync = SYNC_SEMAFOROS;
+    int presupuesto_espera = PRESUPUESTO_ESPERA_DEFECTO;
+    int nodo_numa = -1;     // -1 = politica de memoria por defecto del kernel
+    int tipo_paginas = PAGINAS_NORMALES;
+    int prefault = 0;
+    int buffer_max = 0;     // 0 = buffer de tamano fijo
+    int buffer_min = 1;
+    // Respuestas a las preguntas dadas por linea de comandos (NULL = preguntar por stdin)
+    const char *arg_shm_name = NULL;
+    const char *arg_buffer_size = NULL;
+    const char *arg_llave = NULL;
+    const char *arg_source_file = NULL;
+    const char *manifiesto = NULL;  // Tabla de trabajos en lugar de una sola fuente
+
+    // --- Opciones de linea de comandos (opcionales) ---
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--reclamo") == 0 && i + 1 < argc) {
+            tam_reclamo = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--lectura") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "mmap") == 0) modo_lectura = LECTURA_MMAP;
+            else if (strcmp(argv[i], "stdio") == 0) modo_lectura = LECTURA_STDIO;
+            else if (strcmp(argv[i], "flujo") == 0) modo_lectura = LECTURA_FLUJO;
+            else imprimir_uso_y_salir(argv[0]);
+        } else if (strcmp(argv[i], "--trozo") == 0 && i + 1 < argc) {
+            tam_trozo = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--trozos") == 0 && i + 1 < argc) {
+            num_trozos = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--anillo") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "semaforos") == 0) protocolo_anillo = ANILLO_SEMAFOROS;
+            else if (strcmp(argv[i], "lockfree") == 0) protocolo_anillo = ANILLO_LOCKFREE;
+            else if (strcmp(argv[i], "fragmentado") == 0) protocolo_anillo = ANILLO_FRAGMENTADO;
+            else imprimir_uso_y_salir(argv[0]);
+        } else if (strcmp(argv[i], "--fragmentos") == 0 && i + 1 < argc) {
+            num_fragmentos = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--registro") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "completo") == 0) formato_registro = REGISTRO_COMPLETO;
+            else if (strcmp(argv[i], "compacto") == 0) formato_registro = REGISTRO_COMPACTO;
+            else if (strcmp(argv[i], "bloque") == 0) formato_registro = REGISTRO_BLOQUE;
+            else imprimir_uso_y_salir(argv[0]);
+        } else if (strcmp(argv[i], "--orden") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "llegada") == 0) orden_salida = ORDEN_LLEGADA;
+            else if (strcmp(argv[i], "fuente") == 0) orden_salida = ORDEN_FUENTE;
+            else imprimir_uso_y_salir(argv[0]);
+        } else if (strcmp(argv[i], "--cifrado") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "xor") == 0) algoritmo_cifrado = CIFRADO_XOR;
+            else if (strcmp(argv[i], "chacha20") == 0) algoritmo_cifrado = CIFRADO_CHACHA20;
+            else imprimir_uso_y_salir(argv[0]);
+        } else if (strcmp(argv[i], "--clave") == 0 && i + 1 < argc) {
+            clave_hex = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+            ruta_checkpoint = argv[++i];
+        } else if (strcmp(argv[i], "--checkpoint-cada") == 0 && i + 1 < argc) {
+            checkpoint_cada = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--checkpoint-granulo") == 0 && i + 1 < argc) {
+            granulo_checkpoint = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--reanudar") == 0) {
+            reanudar = 1;
+        } else if (strcmp(argv[i], "--bloque") == 0 && i + 1 < argc) {
+            tam_bloque = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sync") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "semaforos") == 0) backend_sync = SYNC_SEMAFOROS;
+            else if (strcmp(argv[i], "futex") == 0) backend_sync = SYNC_FUTEX;
+            else if (strcmp(argv[i], "robusto") == 0) backend_sync = SYNC_ROBUSTO;
+            else imprimir_uso_y_salir(argv[0]);
+        } else if (strcmp(argv[i], "--espera") == 0 && i + 1 < argc) {
+            presupuesto_espera = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--numa") == 0 && i + 1 < argc) {
+            nodo_numa = atoi(argv[++i]);
+            if (nodo_numa < 0) imprimir_uso_y_salir(argv[0]);
+        } else if (strcmp(argv[i], "--paginas") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "normales") == 0) tipo_paginas = PAGINAS_NORMALES;
+            else if (strcmp(argv[i], "thp") == 0) tipo_paginas = PAGINAS_THP;
+            else if (strcmp(argv[i], "hugetlb") == 0) tipo_paginas = PAGINAS_HUGETLB;
+            else imprimir_uso_y_salir(argv[0]);
+        } else if (strcmp(argv[i], "--prefault") == 0) {
+            prefault = 1;
+        } else if (strcmp(argv[i], "--buffer-max") == 0 && i + 1 < argc) {
+            buffer_max = atoi(argv[++i]);
+            if (buffer_max <= 0) imprimir_uso_y_salir(argv[0]);
+        } else if (strcmp(argv[i], "--buffer-min") == 0 && i + 1 < argc) {
+            buffer_min = atoi(argv[++i]);
+            if (buffer_min <= 0) imprimir_uso_y_salir(argv[0]);
+        } else if (strcmp(argv[i], "--id") == 0 && i + 1 < argc) {
+            arg_shm_name = argv[++i];
+        } else if (strcmp(argv[i], "--buffer") == 0 && i + 1 < argc) {
+            arg_buffer_size = argv[++i];
+        } else if (strcmp(argv[i], "--llave") == 0 && i + 1 < argc) {
+            arg_llave = argv[++i];
+        } else if (strcmp(argv[i], "--fuente") == 0 && i + 1 < argc) {
+            arg_source_file = argv[++i];
+        } else if (strcmp(argv[i], "--manifiesto") == 0 && i + 1 < argc) {
+            manifiesto = argv[++i];
+        } else {
+            imprimir_uso_y_salir(argv[0]);
+        }
+    }
+
+    if (tam_reclamo <= 0) {
+        fprintf(stderr, "El tamano de reclamo debe ser mayor que 0.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (tam_trozo <= 0 || num_trozos <= 0) {
+        fprintf(stderr, "El tamano y la cantidad de trozos deben ser mayores que 0.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (num_fragmentos <= 0) {
+        fprintf(stderr, "La cantidad de fragmentos debe ser mayor que 0.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (protocolo_anillo != ANILLO_FRAGMENTADO) num_fragmentos = 1;
+
+    if (tam_bloque <= 0) {
+        fprintf(stderr, "El tamano de bloque debe ser mayor que 0.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (formato_registro != REGISTRO_BLOQUE) tam_bloque = 1;   // Un caracter por celda
+
+    if (presupuesto_espera < 0) {
+        fprintf(stderr, "El presupuesto de espera no puede ser negativo.\n");
+        exit(EXIT_FAILURE);
+    }
 
     // --- Solicitar Parametros al Usuario ---
+    // Solo se pregunta lo que no vino por linea de comandos (asi el benchmark no es interactivo)
     printf("--- Configuracion del Inicializador ---\n");
 
     // 1. Identificador SHM
-    printf("Ingrese el identificador del espacio compartido: ");
-    fflush(stdout);     // Aseguramos que el prompt se muestre
-    leer_linea(shm_name, sizeof(shm_name));
+    if (arg_shm_name != NULL) {
+        snprintf(shm_name, sizeof(shm_name), "%s", arg_shm_name);
+    } else {
+        printf("Ingrese el identificador del espacio compartido: ");
+        fflush(stdout);     // Aseguramos que el prompt se muestre
+        leer_linea(shm_name, sizeof(shm_name));
+    }
 
     // 2. Tamano del buffer
-    printf("Ingrese la cantidad de espacios del buffer: ");
-    fflush(stdout);
-    leer_linea(buffer_size_str, sizeof(buffer_size_str));
+    if (arg_buffer_size != NULL) {
+        snprintf(buffer_size_str, sizeof(buffer_size_str), "%s", arg_buffer_size);
+    } else {
+        printf("Ingrese la cantidad de espacios del buffer: ");
+        fflush(stdout);
+        leer_linea(buffer_size_str, sizeof(buffer_size_str));
+    }
     buffer_size = atoi(buffer_size_str);    // Convertir string a entero
 
     // 3. Llave
-    printf("Ingrese la llave para desencriptar: ");
-    fflush(stdout);
-    leer_linea(llave_str, sizeof(llave_str));
+    if (arg_llave != NULL) {
+        snprintf(llave_str, sizeof(llave_str), "%s", arg_llave);
+    } else {
+        printf("Ingrese la llave para desencriptar: ");
+        fflush(stdout);
+        leer_linea(llave_str, sizeof(llave_str));
+    }
     llave_num = atoi(llave_str);
 
     if (llave_num < 0 || llave_num > 255){
@@ -57,65 +238,227 @@ int main(int argc, char *argv[]) {
         exit(EXIT_FAILURE);
     }
 
-    // 4. Archivo fuente
-    printf("Ingrese el nombre del archivo fuente: ");
-    fflush(stdout);
-    leer_linea(source_file, sizeof(source_file));
+    // 4. Archivo fuente (con manifiesto, cada trabajo trae el suyo)
+    if (manifiesto != NULL) {
+        snprintf(source_file, sizeof(source_file), "%s", manifiesto);
+    } else if (arg_source_file != NULL) {
+        snprintf(source_file, sizeof(source_file), "%s", arg_source_file);
+    } else {
+        printf("Ingrese el nombre del archivo fuente: ");
+        fflush(stdout);
+        leer_linea(source_file, sizeof(source_file));
+    }
 
     if (buffer_size <= 0) {
         fprintf(stderr, "El tamano del buffer debe ser mayor que 0.\n");
         exit(EXIT_FAILURE);
     }
 
-    // Generar nombres para los semaforos basados en el ID de la memoria
-    char sem_mutex_name[512], sem_empty_name[512], sem_full_name[512], sem_fin_name[512];
-
-    int needed;
-    needed = snprintf(sem_mutex_name, sizeof(sem_mutex_name), "%s%s", shm_name, SEM_MUTEX_NAME_SUFFIX);
-    if (needed < 0 || needed >= (int)sizeof(sem_mutex_name)) {
-        fprintf(stderr, "Error: sem_mutex_name truncation or encoding error (needed=%d, size=%zu)\n", needed, sizeof(sem_mutex_name));
+    // Con anillos fragmentados el buffer se reparte en partes iguales (lo que sobra se descarta)
+    if (buffer_size < num_fragmentos) {
+        fprintf(stderr, "El buffer necesita al menos un espacio por fragmento (%d).\n", num_fragmentos);
         exit(EXIT_FAILURE);
     }
+    int celdas_fragmento = buffer_size / num_fragmentos;
+    buffer_size = celdas_fragmento * num_fragmentos;
+
+    // Manifiesto: solo las celdas de bloque pueden llevar el numero de trabajo, y la
+    // etapa lectora de --lectura flujo lee una sola fuente
+    if (manifiesto != NULL) {
+        if (formato_registro != REGISTRO_BLOQUE) {
+            fprintf(stderr, "--manifiesto requiere --registro bloque.\n");
+            exit(EXIT_FAILURE);
+        }
+        if (modo_lectura == LECTURA_FLUJO) {
+            fprintf(stderr, "--manifiesto no es compatible con --lectura flujo.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
 
-    needed = snprintf(sem_empty_name, sizeof(sem_empty_name), "%s%s", shm_name, SEM_EMPTY_NAME_SUFFIX);
-    if (needed < 0 || needed >= (int)sizeof(sem_empty_name)) {
-        fprintf(stderr, "Error: sem_empty_name truncation or encoding error (needed=%d, size=%zu)\n", needed, sizeof(sem_empty_name));
+    // Orden de fuente: solo las celdas de bloque guardan el offset de la fuente
+    if (orden_salida == ORDEN_FUENTE && formato_registro != REGISTRO_BLOQUE) {
+        fprintf(stderr, "--orden fuente requiere --registro bloque.\n");
         exit(EXIT_FAILURE);
     }
 
-    needed = snprintf(sem_full_name, sizeof(sem_full_name), "%s%s", shm_name, SEM_FULL_NAME_SUFFIX);
-    if (needed < 0 || needed >= (int)sizeof(sem_full_name)) {
-        fprintf(stderr, "Error: sem_full_name truncation or encoding error (needed=%d, size=%zu)\n", needed, sizeof(sem_full_name));
+    // ChaCha20: el receptor necesita el offset de cada unidad para regenerar el keystream.
+    // La clave se da en hexadecimal (32 bytes) o se genera; el nonce es nuevo en cada corrida.
+    uint32_t clave_chacha[8];
+    uint64_t nonce_chacha = 0;
+    if (algoritmo_cifrado == CIFRADO_CHACHA20) {
+        if (formato_registro != REGISTRO_BLOQUE) {
+            fprintf(stderr, "--cifrado chacha20 requiere --registro bloque.\n");
+            exit(EXIT_FAILURE);
+        }
+        unsigned char bytes[32];
+        if (clave_hex != NULL) {
+            if (strlen(clave_hex) != 64) {
+                fprintf(stderr, "--clave debe tener 64 digitos hexadecimales.\n");
+                exit(EXIT_FAILURE);
+            }
+            for (int i = 0; i < 32; i++) {
+                unsigned int byte;
+                if (sscanf(clave_hex + 2 * i, "%2x", &byte) != 1) {
+                    fprintf(stderr, "--clave debe tener 64 digitos hexadecimales.\n");
+                    exit(EXIT_FAILURE);
+                }
+                bytes[i] = (unsigned char)byte;
+            }
+        } else if (getrandom(bytes, sizeof(bytes), 0) != (ssize_t)sizeof(bytes)) {
+            reportar_error_y_salir("getrandom (clave)");
+        }
+        if (getrandom(&nonce_chacha, sizeof(nonce_chacha), 0) != (ssize_t)sizeof(nonce_chacha)) {
+            reportar_error_y_salir("getrandom (nonce)");
+        }
+        // Palabras de la clave en little-endian, como en la especificacion
+        for (int i = 0; i < 8; i++) {
+            clave_chacha[i] = (uint32_t)bytes[4 * i] | (uint32_t)bytes[4 * i + 1] << 8 |
+                              (uint32_t)bytes[4 * i + 2] << 16 | (uint32_t)bytes[4 * i + 3] << 24;
+        }
+    } else if (clave_hex != NULL) {
+        fprintf(stderr, "--clave solo aplica a --cifrado chacha20.\n");
         exit(EXIT_FAILURE);
     }
 
-    needed = snprintf(sem_fin_name, sizeof(sem_fin_name), "%s%s", shm_name, SEM_FIN_NAME_SUFFIX);
-    if (needed < 0 || needed >= (int)sizeof(sem_fin_name)) {
-        fprintf(stderr, "Error: sem_fin_name truncation or encoding error (needed=%d, size=%zu)\n", needed, sizeof(sem_full_name));
+    // Redimensionado en linea: solo con el anillo protegido por sem_prod / sem_cons
+    int redimension = buffer_max > 0;
+    if (redimension) {
+        if (protocolo_anillo != ANILLO_SEMAFOROS) {
+            fprintf(stderr, "--buffer-max solo es compatible con --anillo semaforos.\n");
+            exit(EXIT_FAILURE);
+        }
+        // Una redimension a medias no se puede deshacer desde otro proceso
+        if (backend_sync == SYNC_ROBUSTO) {
+            fprintf(stderr, "--buffer-max no es compatible con --sync robusto.\n");
+            exit(EXIT_FAILURE);
+        }
+        if (buffer_min > buffer_size || buffer_max < buffer_size) {
+            fprintf(stderr, "Se requiere buffer-min (%d) <= buffer (%d) <= buffer-max (%d).\n", buffer_min, buffer_size, buffer_max);
+            exit(EXIT_FAILURE);
+        }
+    } else {
+        buffer_min = buffer_max = buffer_size;
+    }
+
+    // Checkpoint: la salida debe seguir el orden de la fuente para poder recortarla a la
+    // marca, y la fuente debe ser un archivo regular para retomarla en un offset.
+    // Al reanudar, lo escrito despues de la marca puede estar a medias y se descarta.
+    struct stat fuente_info;
+    struct ArchivoCheckpoint previo;
+    long inicio_fuente = 0;
+    if (reanudar && ruta_checkpoint == NULL) {
+        fprintf(stderr, "--reanudar requiere --checkpoint <archivo>.\n");
         exit(EXIT_FAILURE);
     }
+    if (ruta_checkpoint != NULL) {
+        if (orden_salida != ORDEN_FUENTE) {
+            fprintf(stderr, "--checkpoint requiere --orden fuente.\n");
+            exit(EXIT_FAILURE);
+        }
+        if (manifiesto != NULL) {
+            fprintf(stderr, "--checkpoint no es compatible con --manifiesto.\n");
+            exit(EXIT_FAILURE);
+        }
+        if (checkpoint_cada <= 0 || granulo_checkpoint <= 0) {
+            fprintf(stderr, "El intervalo y el granulo del checkpoint deben ser mayores que 0.\n");
+            exit(EXIT_FAILURE);
+        }
+        if (stat(source_file, &fuente_info) == -1 || !S_ISREG(fuente_info.st_mode)) {
+            fprintf(stderr, "--checkpoint requiere que la fuente sea un archivo regular.\n");
+            exit(EXIT_FAILURE);
+        }
+        memset(&previo, 0, sizeof(previo));
+        int leido = reanudar ? checkpoint_archivo_leer(ruta_checkpoint, &previo) : 1;
+        if (leido == -1) exit(EXIT_FAILURE);
+        if (reanudar && leido == 1) printf("No hay checkpoint en %s: se empieza desde el principio.\n", ruta_checkpoint);
+        if (leido == 0) {
+            if (strcmp(previo.fuente, source_file) != 0 || previo.tam_fuente != fuente_info.st_size ||
+                previo.mtime_fuente != fuente_info.st_mtime) {
+                fprintf(stderr, "La fuente %s no es la del checkpoint (%s, %ld bytes) o cambio desde entonces.\n",
+                        source_file, previo.fuente, previo.tam_fuente);
+                exit(EXIT_FAILURE);
+            }
+            struct stat salida_info;
+            if (previo.escrito > 0 && (stat(previo.salida, &salida_info) == -1 || salida_info.st_size < previo.escrito)) {
+                fprintf(stderr, "La salida %s no tiene los %ld bytes del checkpoint: no se puede reanudar.\n",
+                        previo.salida, previo.escrito);
+                exit(EXIT_FAILURE);
+            }
+            if (previo.escrito > 0 && truncate(previo.salida, previo.escrito) == -1) reportar_error_y_salir("truncate (salida)");
+            inicio_fuente = previo.escrito;
+        }
+    }
 
     printf("\n--------------------------------\n");
     printf("--- Resumen de Configuracion ---\n");
     printf("--------------------------------\n");
     printf("Iniciando recursos con ID base: %s\n", shm_name);
     printf("\t -> Buffer size: %d\n", buffer_size);
-    printf("\t -> Llave: %d\n", llave_num);
-    printf("\t -> Archivo: %s\n", source_file);
+    if (algoritmo_cifrado == CIFRADO_CHACHA20) {
+        printf("\t -> Cifrado: chacha20 (clave %s)\n", clave_hex != NULL ? "de --clave" : "aleatoria");
+    } else {
+        printf("\t -> Llave: %d\n", llave_num);
+    }
+    printf("\t -> %s: %s\n", manifiesto != NULL ? "Manifiesto" : "Archivo", source_file);
+    printf("\t -> Reclamo por emisor: %d bytes\n", tam_reclamo);
+    if (modo_lectura == LECTURA_FLUJO) {
+        printf("\t -> Lectura de la fuente: flujo (lector aparte, %d trozos de %d bytes)\n", num_trozos, tam_trozo);
+    } else {
+        printf("\t -> Lectura de la fuente: %s\n", modo_lectura == LECTURA_MMAP ? "mmap" : "stdio");
+    }
+    if (protocolo_anillo == ANILLO_FRAGMENTADO) {
+        printf("\t -> Protocolo del anillo: fragmentado (%d anillos de %d espacios)\n", num_fragmentos, celdas_fragmento);
+    } else {
+        printf("\t -> Protocolo del anillo: %s\n", protocolo_anillo == ANILLO_LOCKFREE ? "lockfree" : "semaforos");
+    }
+    printf("\t -> Registro: %s (%d bytes de datos en %d bytes por celda)\n",
+           formato_registro == REGISTRO_BLOQUE ? "bloque" : formato_registro == REGISTRO_COMPACTO ? "compacto" : "completo",
+           tam_bloque, registro_tam(formato_registro, tam_bloque));
+    printf("\t -> Orden de salida: %s\n", orden_salida == ORDEN_FUENTE ? "fuente (offset de cada byte)" : "llegada");
+    if (backend_sync == SYNC_FUTEX) {
+        printf("\t -> Sincronizacion: futex (giro maximo: %d vueltas)\n", presupuesto_espera);
+    } else if (backend_sync == SYNC_ROBUSTO) {
+        printf("\t -> Sincronizacion: mutex robustos pthread (en el segmento)\n");
+    } else {
+        printf("\t -> Sincronizacion: semaforos POSIX\n");
+    }
+    if (redimension) printf("\t -> Redimension en linea: %d a %d espacios\n", buffer_min, buffer_max);
+    if (ruta_checkpoint != NULL) {
+        printf("\t -> Checkpoint: %s cada %ld ms\n", ruta_checkpoint, checkpoint_cada);
+        if (inicio_fuente > 0) printf("\t -> Reanudando desde el byte %ld de %ld\n", inicio_fuente, (long)fuente_info.st_size);
+    }
     printf("--------------------------------\n");
 
     // --- Limpiar recursos antiguos ---
-    shm_unlink(shm_name);
-    sem_unlink(sem_mutex_name);
-    sem_unlink(sem_empty_name);
-    sem_unlink(sem_full_name);
-    sem_unlink(sem_fin_name);
+    segmento_eliminar(shm_name);
+    sincronizacion_eliminar(shm_name);
+    flujo_eliminar(shm_name);
+    trabajos_eliminar(shm_name);
+    checkpoint_eliminar(shm_name);
 
     // --- Crear Memoria Compartida (SHM) ---
-    int shm_fd = shm_open(shm_name, O_CREAT | O_RDWR, 0666);
-    if (shm_fd == -1) reportar_error_y_salir("Error en shm_open");
+    int shm_fd = segmento_crear(shm_name, tipo_paginas);
+    if (shm_fd == -1) {
+        if (tipo_paginas == PAGINAS_HUGETLB) {
+            fprintf(stderr, "No se pudo crear el segmento en %s (¿hugetlbfs montado?).\n", DIR_HUGETLBFS);
+        }
+        reportar_error_y_salir("Error en shm_open");
+    }
+
+    size_t total_size = sizeof(struct MemoriaCompartida) + ((size_t)buffer_size * registro_tam(formato_registro, tam_bloque));
+    if (protocolo_anillo == ANILLO_LOCKFREE) total_size += anillo_tam_extra(buffer_size);
+    if (protocolo_anillo == ANILLO_FRAGMENTADO) {
+        total_size += fragmentos_tam_extra(buffer_size, registro_tam(formato_registro, tam_bloque), num_fragmentos);
+    }
 
-    size_t total_size = sizeof(struct MemoriaCompartida) + (buffer_size * sizeof(struct CharInfo));
+    // En hugetlbfs el segmento ocupa paginas enteras: se redondea para que todos mapeen st_size
+    long tam_pagina = sysconf(_SC_PAGESIZE);
+    if (tipo_paginas == PAGINAS_HUGETLB) {
+        tam_pagina = segmento_tam_pagina_fs(shm_fd);
+        if (tam_pagina <= 0) reportar_error_y_salir("Error en fstatfs (hugetlbfs)");
+        total_size = (total_size + tam_pagina - 1) / tam_pagina * tam_pagina;
+    }
+    if (redimension) total_size = redimension_tam_segmento(registro_tam(formato_registro, tam_bloque), buffer_size, tam_pagina);
 
     if (ftruncate(shm_fd, total_size) == -1) reportar_error_y_salir("Error en ftruncate");
 
@@ -125,43 +468,148 @@ int main(int argc, char *argv[]) {
 
     if (memoria == MAP_FAILED) reportar_error_y_salir("Error en mmap");
 
-    // --- Crear Semaforos ---
-    sem_t *sem_mutex = sem_open(sem_mutex_name, O_CREAT, 0666, 1);
-    if (sem_mutex == SEM_FAILED) reportar_error_y_salir("Error en sem_open (mutex)");
-
-    sem_t *sem_empty = sem_open(sem_empty_name, O_CREAT, 0666, buffer_size);
-    if (sem_empty == SEM_FAILED) reportar_error_y_salir("Error en sem_open (empty)");
-
-    sem_t *sem_full = sem_open(sem_full_name, O_CREAT, 0666, 0);
-    if (sem_full == SEM_FAILED) reportar_error_y_salir("Error en sem_open (full)");
+    // --- Ligar el segmento a un nodo NUMA ---
+    // Debe hacerse antes del primer acceso: las paginas se asignan al tocarlas en la inicializacion
+    if (nodo_numa >= 0) {
+        if (afinidad_ligar_memoria(memoria, total_size, nodo_numa) == -1) reportar_error_y_salir("Error en mbind (--numa)");
+        printf("Segmento ligado al nodo NUMA %d.\n", nodo_numa);
+    }
 
-    sem_t *sem_fin = sem_open(sem_fin_name, O_CREAT, 0666, 0);
-    if (sem_fin == SEM_FAILED) reportar_error_y_salir("Error en sem_open (full)");
+    // --- Paginas grandes y prefault ---
+    // Ambos despues de mbind y antes del primer acceso (por eso no se usa MAP_POPULATE en el mmap)
+    if (tipo_paginas == PAGINAS_THP && madvise(memoria, total_size, MADV_HUGEPAGE) == -1) {
+        reportar_error_y_salir("Error en madvise (MADV_HUGEPAGE)");
+    }
+    if (prefault) segmento_prefaltear(memoria, total_size, tam_pagina);
 
     // --- Inicializar Valores en Memoria Compartida ---
     printf("Inicializando estructura de memoria compartida...\n");
     memoria->buffer_size = buffer_size;
-    memoria->idx_escritura = 0;
-    memoria->idx_lectura = 0;
-    memoria->idx_archivo_lectura = 0;
-    memoria->idx_archivo_escritura = 0;
-    memoria->total_producidos = 0;
-    memoria->total_consumidos = 0;
+    memoria->productores.idx_escritura = 0;
+    memoria->consumidores.idx_lectura = 0;
+    memoria->productores.idx_archivo_lectura = inicio_fuente;
+    memoria->consumidores.idx_archivo_escritura = 0;
+    memoria->consumidores.fin_salida = inicio_fuente;
+    memoria->tam_reclamo = tam_reclamo;
+    memoria->modo_lectura = modo_lectura;
+    memoria->manifiesto = manifiesto != NULL;
+    memoria->orden_salida = orden_salida;
+    memoria->checkpoint = ruta_checkpoint != NULL;
+    memoria->inicio_fuente = inicio_fuente;
+    memoria->protocolo_anillo = protocolo_anillo;
+    memoria->num_fragmentos = num_fragmentos;
+    memoria->celdas_fragmento = celdas_fragmento;
+    memoria->formato_registro = formato_registro;
+    memoria->tam_bloque = tam_bloque;
+    memoria->tam_registro = registro_tam(formato_registro, tam_bloque);
+    memoria->tiempo_base = time(NULL);
+    struct timespec ahora;
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    memoria->base_monotonica_ns = (int64_t)ahora.tv_sec * 1000000000LL + ahora.tv_nsec;
+    memoria->backend_sync = backend_sync;
+    memoria->presupuesto_espera = presupuesto_espera;
+    memoria->tipo_paginas = tipo_paginas;
+    memoria->prefault = prefault;
+    memoria->redimension = redimension;
+    memoria->buffer_min = buffer_min;
+    memoria->buffer_max = buffer_max;
+    memoria->generacion = 0;
+    memoria->veces_crecido = 0;
+    memoria->veces_reducido = 0;
+    memoria->productores.celdas_escritas = 0;
+    memoria->consumidores.celdas_leidas = 0;
+    memset(&memoria->productores.redimension, 0, sizeof(memoria->productores.redimension));
+    memoria->productores.total_producidos = 0;
+    memoria->consumidores.total_consumidos = 0;
     memoria->shutdown_flag = 0;
     memoria->emisores_activos = 0;
     memoria->receptores_activos = 0;
     memoria->emisores_totales = 0;
     memoria->receptores_totales = 0;
+    memoria->emisores_hilos = 0;
+    memoria->receptores_hilos = 0;
+    memoria->trabajadores_purgados = 0;
+    memset(&memoria->productores.deshacer, 0, sizeof(memoria->productores.deshacer));
+    memset(&memoria->consumidores.deshacer, 0, sizeof(memoria->consumidores.deshacer));
+    memset(memoria->metricas, 0, sizeof(memoria->metricas));
+    memset(memoria->latencias, 0, sizeof(memoria->latencias));
     memoria->llave_desencriptar = (unsigned char)llave_num;
+    memoria->algoritmo_cifrado = algoritmo_cifrado;
+    if (algoritmo_cifrado == CIFRADO_CHACHA20) memcpy(memoria->clave_chacha, clave_chacha, sizeof(clave_chacha));
+    memoria->nonce_chacha = nonce_chacha;
     strncpy(memoria->archivo_fuente, source_file, sizeof(memoria->archivo_fuente) - 1);
 
-    memset(memoria->buffer, 0, buffer_size * sizeof(struct CharInfo));
+    memset(memoria->buffer, 0, (size_t)buffer_size * memoria->tam_registro);
+    if (protocolo_anillo == ANILLO_LOCKFREE) anillo_inicializar(memoria);
+    if (protocolo_anillo == ANILLO_FRAGMENTADO) fragmentos_inicializar(memoria);
+
+    // --- Reportar el tamano de pagina realmente usado (el buffer ya esta tocado entero) ---
+    long pagina_kb, thp_kb;
+    memoria->tam_pagina = tam_pagina;
+    if (segmento_paginas_reales(memoria, &pagina_kb, &thp_kb) == 0) {
+        if (pagina_kb > 0) memoria->tam_pagina = pagina_kb * 1024;
+        if (thp_kb > 0) memoria->tam_pagina = segmento_tam_thp();
+        printf("Segmento: %zu bytes, pagina de %ld KiB", total_size, memoria->tam_pagina / 1024);
+        if (tipo_paginas == PAGINAS_THP) printf(" (%ld KiB mapeados con THP)", thp_kb);
+        printf("%s\n", prefault ? ", prefaulteado" : "");
+        if (tipo_paginas == PAGINAS_THP && thp_kb == 0) {
+            fprintf(stderr, "Aviso: el kernel no asigno THP al segmento (revisar /sys/kernel/mm/transparent_hugepage/shmem_enabled).\n");
+        }
+    }
+
+    // Cada trabajador mapea el segmento a su tamano maximo (con el tamano de pagina ya conocido)
+    memoria->tam_mapeo = redimension ? redimension_tam_segmento(memoria->tam_registro, buffer_max, memoria->tam_pagina) : total_size;
+
+    // --- Crear Semaforos ---
+    // Con SYNC_FUTEX y SYNC_ROBUSTO viven dentro del segmento y no se crea ningun semaforo con nombre.
+    // Los locks de emisores (prod) y receptores (cons) son separados: cada grupo solo compite consigo mismo.
+    struct Sincronizacion sync;
+    sincronizacion_crear(&sync, shm_name, memoria);
+
+    // --- Cola de trozos del lector (segmento aparte) ---
+    if (modo_lectura == LECTURA_FLUJO) {
+        size_t tam_cola;
+        struct ColaTrozos *cola = flujo_crear(shm_name, num_trozos, tam_trozo, presupuesto_espera, &tam_cola);
+        flujo_cerrar(cola, tam_cola);
+        printf("Cola de trozos creada: %zu bytes. Lance ./build/lector %s junto con los emisores.\n", tam_cola, shm_name);
+    }
+
+    // --- Tabla de trabajos del manifiesto (segmento aparte) ---
+    if (manifiesto != NULL) {
+        size_t tam_tabla;
+        struct TablaTrabajos *tabla = trabajos_crear(shm_name, manifiesto, orden_salida, &tam_tabla);
+        if (tabla == NULL) {
+            segmento_eliminar(shm_name);
+            sincronizacion_eliminar(shm_name);
+            trabajos_eliminar(shm_name);
+            exit(EXIT_FAILURE);
+        }
+        long total = 0;
+        for (int i = 0; i < tabla->num_trabajos; i++) total += tabla->trabajos[i].tam;
+        printf("Tabla de trabajos creada: %d archivos, %ld bytes de fuente.\n", tabla->num_trabajos, total);
+        trabajos_cerrar(tabla, tam_tabla);
+    }
+
+    // --- Marca de lo escrito (segmento aparte) ---
+    // El archivo lateral se reescribe ya: uno viejo de otra corrida no debe quedar como valido
+    if (ruta_checkpoint != NULL) {
+        size_t tam_cp;
+        struct Checkpoint *cp = checkpoint_crear(shm_name, ruta_checkpoint, source_file, &fuente_info, inicio_fuente,
+                                                 granulo_checkpoint, checkpoint_cada, &tam_cp);
+        snprintf(cp->salida, sizeof(cp->salida), "%s", previo.salida);
+        if (checkpoint_guardar(cp) == -1) {
+            segmento_eliminar(shm_name);
+            sincronizacion_eliminar(shm_name);
+            flujo_eliminar(shm_name);
+            checkpoint_eliminar(shm_name);
+            exit(EXIT_FAILURE);
+        }
+        printf("Checkpoint creado: %ld granulos de %ld bytes.\n", cp->num_granulos, cp->granulo);
+        checkpoint_cerrar(cp, tam_cp);
+    }
 
     // --- Limpieza del proceso inicializador ---
-    sem_close(sem_mutex);
-    sem_close(sem_empty);
-    sem_close(sem_full);
-    sem_close(sem_fin);
+    sincronizacion_cerrar(&sync);
 
     munmap(memoria, total_size);
     close(shm_fd);
@@ -0,0 +1,103 @@
+#ifndef LATENCIA_H
+#define LATENCIA_H
+
+#include <stdio.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include "memInfo.h"
+
+// Histogramas de latencia de extremo a extremo en memoria->latencias.
+// Cada receptor reclama una ranura y es su unico escritor, por lo que los
+// contadores se actualizan con carga + almacenamiento relajados (sin RMW).
+// El finalizador los lee cuando ya no queda nadie escribiendo.
+
+// Cubeta de un valor: lineal por debajo de LAT_SUB, luego LAT_SUB sub-cubetas por potencia de dos
+static inline int latencia_cubeta(long valor_ns) {
+    if (valor_ns < LAT_SUB) return valor_ns < 0 ? 0 : (int)valor_ns;
+    int exponente = 63 - __builtin_clzl((unsigned long)valor_ns);
+    if (exponente > LAT_EXP_MAX) return LAT_CUBETAS - 1;
+    int sub = (int)(valor_ns >> (exponente - LAT_BITS_SUB)) - LAT_SUB;
+    return LAT_SUB + (exponente - LAT_BITS_SUB) * LAT_SUB + sub;
+}
+
+// Mayor valor que cae en la cubeta (asi los percentiles nunca se subestiman)
+static inline long latencia_tope_cubeta(int cubeta) {
+    if (cubeta < LAT_SUB) return cubeta;
+    int exponente = (cubeta - LAT_SUB) / LAT_SUB + LAT_BITS_SUB;
+    long sub = (cubeta - LAT_SUB) % LAT_SUB;
+    long ancho = 1L << (exponente - LAT_BITS_SUB);
+    return (LAT_SUB + sub) * ancho + ancho - 1;
+}
+
+static inline void latencia_incrementar(_Atomic long *contador, long valor) {
+    atomic_store_explicit(contador, atomic_load_explicit(contador, memory_order_relaxed) + valor, memory_order_relaxed);
+}
+
+static inline void latencia_registrar(struct HistogramaLatencia *h, long valor_ns) {
+    if (valor_ns < 0) valor_ns = 0;
+    latencia_incrementar(&h->cuentas[latencia_cubeta(valor_ns)], 1);
+    latencia_incrementar(&h->total, 1);
+    latencia_incrementar(&h->suma_ns, valor_ns);
+    if (valor_ns > atomic_load_explicit(&h->maximo_ns, memory_order_relaxed)) {
+        atomic_store_explicit(&h->maximo_ns, valor_ns, memory_order_relaxed);
+    }
+}
+
+// Reclama una ranura libre; si la tabla esta llena se devuelve una ranura local descartable
+static inline struct LatenciaReceptor *latencia_registrar_receptor(struct MemoriaCompartida *memoria) {
+    static struct LatenciaReceptor descartada;
+    for (int i = 0; i < MAX_RECEPTORES_LATENCIA; i++) {
+        int libre = 0;
+        if (atomic_compare_exchange_strong(&memoria->latencias[i].pid, &libre, id_trabajador())) {
+            return &memoria->latencias[i];
+        }
+    }
+    return &descartada;
+}
+
+// Acumula 'origen' en 'destino' (para el histograma combinado)
+static inline void latencia_sumar(struct HistogramaLatencia *destino, const struct HistogramaLatencia *origen) {
+    for (int i = 0; i < LAT_CUBETAS; i++) latencia_incrementar(&destino->cuentas[i], origen->cuentas[i]);
+    latencia_incrementar(&destino->total, origen->total);
+    latencia_incrementar(&destino->suma_ns, origen->suma_ns);
+    if (origen->maximo_ns > destino->maximo_ns) destino->maximo_ns = origen->maximo_ns;
+}
+
+// Valor bajo el que queda la fraccion 'p' (0..1) de las muestras
+static inline long latencia_percentil(const struct HistogramaLatencia *h, double p) {
+    long total = atomic_load(&h->total);
+    if (total == 0) return 0;
+    long objetivo = (long)(p * total + 0.999999);
+    if (objetivo < 1) objetivo = 1;
+    long acumulado = 0;
+    for (int i = 0; i < LAT_CUBETAS; i++) {
+        acumulado += atomic_load_explicit(&h->cuentas[i], memory_order_relaxed);
+        if (acumulado >= objetivo) {
+            long tope = latencia_tope_cubeta(i);
+            long maximo = atomic_load(&h->maximo_ns);
+            return tope < maximo ? tope : maximo;
+        }
+    }
+    return atomic_load(&h->maximo_ns);
+}
+
+// Escribe una duracion en ns con la unidad mas legible
+static inline void latencia_formatear(char *destino, size_t tam, long ns) {
+    if (ns < 1000) snprintf(destino, tam, "%ld ns", ns);
+    else if (ns < 1000000) snprintf(destino, tam, "%.1f us", ns / 1e3);
+    else if (ns < 1000000000) snprintf(destino, tam, "%.1f ms", ns / 1e6);
+    else snprintf(destino, tam, "%.2f s", ns / 1e9);
+}
+
+// Linea de resumen: muestras, p50, p99, p99.9 y maximo
+static inline void latencia_imprimir(const char *etiqueta, const struct HistogramaLatencia *h) {
+    char p50[32], p99[32], p999[32], maximo[32];
+    latencia_formatear(p50, sizeof(p50), latencia_percentil(h, 0.50));
+    latencia_formatear(p99, sizeof(p99), latencia_percentil(h, 0.99));
+    latencia_formatear(p999, sizeof(p999), latencia_percentil(h, 0.999));
+    latencia_formatear(maximo, sizeof(maximo), atomic_load(&h->maximo_ns));
+    printf("  %-22s n=%-9ld p50=%-10s p99=%-10s p99.9=%-10s max=%s\n",
+           etiqueta, atomic_load(&h->total), p50, p99, p999, maximo);
+}
+
+#endif // LATENCIA_H
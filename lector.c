@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>     // Para read, close, lseek
+#include <fcntl.h>      // Para open, posix_fadvise
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include "memInfo.h"
+#include "sincronizacion.h"
+#include "metricas.h"
+#include "segmento.h"
+#include "redimension.h"
+#include "flujo.h"      // Cola de trozos de LECTURA_FLUJO
+
+// Etapa lectora del modo --lectura flujo: el unico proceso que toca la fuente.
+// La lee de forma secuencial en trozos de tam_trozo bytes y los deja en la cola
+// <shm_id>_trozos, adelantandose hasta num_trozos trozos a los emisores.
+
+#define ANSI_COLOR_MAGENTA "\x1b[35m"
+#define ANSI_COLOR_GREEN   "\x1b[32m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+void reportar_error_y_salir(const char *msg) {
+    perror(msg);
+    exit(EXIT_FAILURE);
+}
+
+// Llena 'datos' con hasta 'tam' bytes. Con archivos regulares solo devuelve menos
+// al final; con pipes y FIFOs publica lo que haya llegado en vez de esperar a llenar
+// el trozo. Devuelve 0 en el fin de la fuente.
+ssize_t leer_trozo(int fd, unsigned char *datos, size_t tam) {
+    for (;;) {
+        ssize_t n = read(fd, datos, tam);
+        if (n >= 0) return n;
+        if (errno != EINTR) reportar_error_y_salir("read (fuente)");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "Uso: %s <shm_id>\n"
+                        "  Lee la fuente configurada con --lectura flujo ('-' = stdin de este proceso).\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    const char *shm_name = argv[1];
+
+    // --- Conectar al segmento principal (configuracion y bandera de cierre) ---
+    int shm_fd = segmento_abrir(shm_name, O_RDWR);
+    if (shm_fd == -1) reportar_error_y_salir("Error en shm_open");
+    size_t total_size, tam_archivo;
+    struct MemoriaCompartida *memoria = redimension_mapear(shm_fd, &total_size, &tam_archivo);
+    close(shm_fd);
+
+    if (memoria->modo_lectura != LECTURA_FLUJO) {
+        fprintf(stderr, "Error: el segmento no se inicializo con --lectura flujo.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t tam_cola;
+    struct ColaTrozos *cola = flujo_abrir(shm_name, &tam_cola);
+    if (atomic_exchange(&cola->lector_activo, 1) != 0) {
+        fprintf(stderr, "Error: ya hay un lector conectado a %s.\n", shm_name);
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Abrir la fuente ---
+    int fd = STDIN_FILENO;
+    if (strcmp(memoria->archivo_fuente, "-") != 0) {
+        fd = open(memoria->archivo_fuente, O_RDONLY);
+        if (fd == -1) {
+            fprintf(stderr, "Error al abrir el archivo fuente: %s\n", memoria->archivo_fuente);
+            reportar_error_y_salir("open");
+        }
+    }
+    // Al reanudar desde un checkpoint la fuente es un archivo regular: se salta lo ya escrito
+    long offset = memoria->inicio_fuente;
+    if (offset > 0 && lseek(fd, offset, SEEK_SET) == -1) reportar_error_y_salir("lseek (fuente)");
+    // Lectura adelantada del kernel mas agresiva (sin efecto en pipes)
+    posix_fadvise(fd, offset, 0, POSIX_FADV_SEQUENTIAL);
+
+    printf(ANSI_COLOR_MAGENTA "--- Lector (PID: %d) ---" ANSI_COLOR_RESET " fuente %s, %d trozos de %d bytes\n",
+           getpid(), strcmp(memoria->archivo_fuente, "-") == 0 ? "stdin" : memoria->archivo_fuente,
+           cola->num_trozos, cola->tam_trozo);
+    fflush(stdout);
+
+    // --- Bucle: reservar un trozo libre, llenarlo y publicarlo ---
+    long inicio = metricas_ahora_ns();
+    unsigned long pos = 0;
+    int cierre = 0;
+    for (;;) {
+        unsigned char *datos = flujo_reservar(cola, pos, &memoria->shutdown_flag, memoria->presupuesto_espera);
+        if (datos == NULL) {
+            cierre = 1;
+            break;
+        }
+        ssize_t n = leer_trozo(fd, datos, cola->tam_trozo);
+        if (n == 0) {
+            // El trozo reservado no se usa: vuelve a quedar libre
+            sem_futex_senalar(&cola->libres);
+            break;
+        }
+        flujo_publicar(cola, pos, offset, (int)n);
+        offset += n;
+        pos++;
+    }
+    // En un cierre los emisores ya ven shutdown_flag: solo hace falta despertarlos
+    if (cierre) sem_futex_senalar(&cola->llenos);
+    else flujo_terminar(cola);
+    double segundos = (metricas_ahora_ns() - inicio) / 1e9;
+
+    printf(ANSI_COLOR_GREEN "--- Lector (PID: %d): %s ---" ANSI_COLOR_RESET "\n", getpid(),
+           cierre ? "cierre solicitado" : "fin de la fuente");
+    long leidos = offset - memoria->inicio_fuente;
+    printf("Bytes leidos: %ld en %lu trozos (%.1f MiB/s)\n", leidos, pos,
+           segundos > 0 ? leidos / segundos / (1024.0 * 1024.0) : 0.0);
+    printf("Espera con la cola llena: %.3f s\n", atomic_load(&cola->ns_esperando_libre) / 1e9);
+
+    if (fd != STDIN_FILENO) close(fd);
+    flujo_cerrar(cola, tam_cola);
+    munmap(memoria, total_size);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>       // Para localtime, strftime
+#include <ctype.h>      // Para isprint
+#include <sys/stat.h>   // Para fstat
+#include "bitacora.h"   // Formato de la bitacora binaria
+
+// --- Codigos de color ANSI (los mismos que usan emisor y receptor)
+#define ANSI_COLOR_BLUE     "\x1b[34m"
+#define ANSI_COLOR_CYAN     "\x1b[36m"
+#define ANSI_COLOR_GREEN    "\x1b[32m"
+#define ANSI_COLOR_YELLOW   "\x1b[33m"
+#define ANSI_COLOR_MAGENTA  "\x1b[35m"
+#define ANSI_COLOR_RED      "\x1b[31m"
+#define ANSI_COLOR_RESET    "\x1b[0m"
+
+void reportar_error_y_salir(const char *msg) {
+    perror(msg);
+    exit(EXIT_FAILURE);
+}
+
+// Evento de una bitacora junto con los datos de la cabecera de su archivo
+struct EventoFusionado {
+    int64_t t_real_ns;              // Hora real reconstruida a partir de las bases del archivo
+    int32_t pid;
+    int32_t tipo;
+    struct EventoBitacora evento;
+};
+
+static int comparar_eventos(const void *a, const void *b) {
+    const struct EventoFusionado *x = a;
+    const struct EventoFusionado *y = b;
+    if (x->t_real_ns != y->t_real_ns) return x->t_real_ns < y->t_real_ns ? -1 : 1;
+    return x->pid - y->pid;
+}
+
+// Lee una bitacora completa y agrega sus eventos al arreglo fusionado
+static void cargar_bitacora(const char *ruta, struct EventoFusionado **eventos, size_t *cantidad, size_t *capacidad) {
+    FILE *archivo = fopen(ruta, "rb");
+    if (archivo == NULL) reportar_error_y_salir(ruta);
+
+    struct CabeceraBitacora cabecera;
+    if (fread(&cabecera, sizeof(cabecera), 1, archivo) != 1 ||
+        memcmp(cabecera.magia, BITACORA_MAGIA, sizeof(cabecera.magia)) != 0) {
+        fprintf(stderr, "Error: '%s' no es una bitacora valida.\n", ruta);
+        exit(EXIT_FAILURE);
+    }
+
+    struct EventoBitacora evento;
+    while (fread(&evento, sizeof(evento), 1, archivo) == 1) {
+        if (*cantidad == *capacidad) {
+            *capacidad = *capacidad ? *capacidad * 2 : BITACORA_EVENTOS;
+            *eventos = realloc(*eventos, *capacidad * sizeof(**eventos));
+            if (*eventos == NULL) reportar_error_y_salir("realloc (eventos)");
+        }
+        struct EventoFusionado *destino = &(*eventos)[(*cantidad)++];
+        destino->t_real_ns = cabecera.base_real_ns + (evento.t_ns - cabecera.base_monotonica_ns);
+        destino->pid = cabecera.pid;
+        destino->tipo = cabecera.tipo;
+        destino->evento = evento;
+    }
+    fclose(archivo);
+}
+
+// Misma fila que imprimen emisor y receptor en modo normal
+static void imprimir_evento(const struct EventoFusionado *e) {
+    const char *colores_emisor[] = { ANSI_COLOR_CYAN, ANSI_COLOR_GREEN, ANSI_COLOR_YELLOW, ANSI_COLOR_MAGENTA };
+    const char *colores_receptor[] = { ANSI_COLOR_BLUE, ANSI_COLOR_GREEN, ANSI_COLOR_YELLOW, ANSI_COLOR_RED };
+    int es_emisor = e->tipo == EVENTO_EMISOR;
+    const char *color = es_emisor ? colores_emisor[e->pid % 4] : colores_receptor[e->pid % 4];
+
+    char time_str[64];
+    time_t segundos = (time_t)(e->t_real_ns / 1000000000LL);
+    strftime(time_str, sizeof(time_str), "%H:%M:%S", localtime(&segundos));
+
+    printf("%s[%s (PID: %d)]%s -> | ", color, es_emisor ? "EMISOR" : "RECEPTOR", e->pid, ANSI_COLOR_RESET);
+    if (e->evento.longitud == 1) {
+        char original_printable = isprint(e->evento.original) ? (char)e->evento.original : '?';
+        char cifrado_printable = isprint(e->evento.cifrado) ? (char)e->evento.cifrado : '?';
+        printf("Original: " ANSI_COLOR_YELLOW "'%c'" ANSI_COLOR_RESET " | ", original_printable);
+        printf("Cifrado: " ANSI_COLOR_GREEN "'%c' (0x%02X)" ANSI_COLOR_RESET " | ", cifrado_printable, e->evento.cifrado);
+    } else {
+        printf("Bloque: " ANSI_COLOR_YELLOW "%u bytes" ANSI_COLOR_RESET " | ", e->evento.longitud);
+        printf("Offset: " ANSI_COLOR_GREEN "%lld" ANSI_COLOR_RESET " | ", (long long)e->evento.offset_fuente);
+    }
+    printf("Indice: %-4d | ", e->evento.indice);
+    printf("Hora: %s |\n", time_str);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Uso: %s <bitacora.bin> [bitacora.bin ...]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    struct EventoFusionado *eventos = NULL;
+    size_t cantidad = 0, capacidad = 0;
+    for (int i = 1; i < argc; i++) {
+        cargar_bitacora(argv[i], &eventos, &cantidad, &capacidad);
+    }
+
+    // Las bitacoras de distintos procesos se intercalan por hora de evento
+    qsort(eventos, cantidad, sizeof(*eventos), comparar_eventos);
+
+    printf(ANSI_COLOR_CYAN "--------------------------------------------------------------------------------------" ANSI_COLOR_RESET "\n");
+    printf(ANSI_COLOR_CYAN "%-20s | %-12s | %-20s | %-8s | %-10s |\n" ANSI_COLOR_RESET,
+           "PROCESO", "ORIGINAL", "CIFRADO (HEX)", "ÍNDICE", "HORA");
+    printf(ANSI_COLOR_CYAN "--------------------------------------------------------------------------------------" ANSI_COLOR_RESET "\n");
+    for (size_t i = 0; i < cantidad; i++) {
+        imprimir_evento(&eventos[i]);
+    }
+    printf(ANSI_COLOR_CYAN "--------------------------------------------------------------------------------------" ANSI_COLOR_RESET "\n");
+    printf("Eventos: %zu en %d bitacoras\n", cantidad, argc - 1);
+
+    free(eventos);
+    return EXIT_SUCCESS;
+}
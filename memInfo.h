@@ -2,46 +2,305 @@
 #define MEMINFO_H
 
 #include <time.h>
+#include <stdint.h>
 #include <semaphore.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>         // Para syscall
+#include <sys/syscall.h>    // Para SYS_gettid
 
 struct CharInfo {
     char valor_ascii;   // Valor del caracter
     int indice;         // Posicion donde fue insertado
-    time_t timestamp;   // Hora de insercion
+    int64_t timestamp_ns;   // CLOCK_MONOTONIC al encolar (ns)
 };
 
-struct MemoriaCompartida {
-    int buffer_size;                // Tamano N del buffer
+// Registro empaquetado de 8 bytes para REGISTRO_COMPACTO (ver registro.h).
+// El indice es la propia celda; la marca son los ns desde base_monotonica_ns
+// en 48 bits (saturada a unas 78 horas).
+struct CharInfoCompacta {
+    uint32_t marca_ns_baja;     // Bits 0..31 de la marca
+    uint16_t marca_ns_alta;     // Bits 32..47 de la marca
+    char valor_ascii;           // Valor del caracter
+    unsigned char reservado;
+};
+
+// Cabecera de cada celda en REGISTRO_BLOQUE; le siguen tam_bloque bytes de datos
+struct CabeceraBloque {
+    int64_t offset_fuente;  // Posicion en el archivo fuente del primer byte de la corrida
+    int64_t timestamp_ns;   // CLOCK_MONOTONIC al encolar (ns)
+    uint32_t longitud;      // Bytes validos en la corrida
+    int32_t indice;         // Posicion donde fue insertado
+    int32_t trabajo;        // Trabajo del manifiesto al que pertenece (0 sin manifiesto)
+    uint32_t reservado;
+};
+
+#define TAM_LINEA_CACHE 64          // Bytes de una linea de cache (x86-64 / ARMv8)
+
+// Identificador de un emisor/receptor: su TID, que coincide con el PID cuando
+// el trabajador es un proceso hijo y distingue a los hilos en el modo --hilos
+static inline int id_trabajador(void) {
+    return (int)syscall(SYS_gettid);
+}
+
+// --- Semaforos del sistema (indices de sync_futex y sync_robusto, ver sincronizacion.h) ---
+#define SYNC_MUTEX 0
+#define SYNC_PROD  1
+#define SYNC_CONS  2
+#define SYNC_EMPTY 3
+#define SYNC_FULL  4
+#define SYNC_FIN   5
+#define SYNC_TOTAL 6
+
+// Semaforo contador embebido en el segmento para SYNC_FUTEX
+struct SemFutex {
+    _Alignas(TAM_LINEA_CACHE) _Atomic int valor;    // Valor del semaforo (palabra del futex)
+    _Atomic int esperando;          // Procesos dormidos en el futex
+    _Atomic int giro_adaptativo;    // Vueltas de giro actuales (<= presupuesto_espera)
+};
+
+// Semaforo de SYNC_ROBUSTO embebido en el segmento: mutex PTHREAD_MUTEX_ROBUST compartido
+// entre procesos. mutex, prod y cons son el propio mutex (tomado durante la seccion critica);
+// empty, full y fin son un contador protegido por el mutex; se duerme en un futex sobre
+// 'secuencia' y no en un pthread_cond_t, que puede trabar a quien senala si muere alguien
+// que esperaba en el.
+struct SemRobusto {
+    _Alignas(TAM_LINEA_CACHE) pthread_mutex_t mutex;
+    _Atomic int secuencia;          // Contadores: palabra del futex, cambia en cada senal
+    int valor;                      // Contadores: valor del semaforo; locks: 1 = libre
+    int esperando;                  // Procesos dormidos en el futex (aproximado si alguno muere)
+    _Atomic long recuperaciones;    // Veces que se tomo con EOWNERDEAD (su dueno murio)
+};
+
+// Estado de una seccion del anillo antes de modificarla, para deshacerla si su dueno
+// muere a mitad (solo SYNC_ROBUSTO, ver sincronizacion_reparar)
+struct RegistroDeshacer {
+    int activo;                     // 1 = hay una modificacion a medias
+    int ranura;                     // Ranura de metricas del dueno (-1 = sin ranura)
+    int idx;                        // idx_escritura / idx_lectura previo
+    long celdas;                    // celdas_escritas / celdas_leidas previo
+    long archivo;                   // idx_archivo_escritura previo (solo receptores)
+    long total;                     // total_producidos / total_consumidos previo
+};
+
+// Contador de eventos con futex: quien no encuentra trabajo anota que duerme,
+// relee la secuencia y espera a que cambie; quien publica solo la avanza si hay dormidos
+struct EventoFutex {
+    _Alignas(TAM_LINEA_CACHE) _Atomic int secuencia;    // Palabra del futex
+    _Atomic int dormidos;           // Procesos dormidos (o por dormir) en el futex
+};
+
+// Cabecera de cada anillo de ANILLO_FRAGMENTADO (ver fragmentos.h). El lado del
+// emisor dueno y el de los receptores quedan en lineas de cache distintas.
+struct Fragmento {
+    _Alignas(TAM_LINEA_CACHE) unsigned long pos_encolar;    // Solo la escribe el emisor dueno
+    _Atomic long unidades;          // Unidades encoladas en este anillo
+    struct SemFutex libres;         // Celdas libres: solo espera el emisor dueno
+    _Alignas(TAM_LINEA_CACHE) _Atomic unsigned long pos_desencolar;
+    _Atomic long robadas;           // Unidades que tomo un receptor de otra casa
+    struct SemFutex llenos;         // Celdas llenas: los receptores solo lo intentan, nunca duermen en el
+};
+
+// Observacion de la politica de redimensionado del buffer (ver redimension.h)
+struct EstadoRedimension {
+    long ventana_desde;             // Inicio de la ventana de observacion (ns, CLOCK_MONOTONIC)
+    long ns_esperando;              // Suma de las esperas de los emisores en sem_empty durante la ventana
+    long ocupacion_maxima;          // Mayor cantidad de celdas llenas vista en la ventana
+};
+
+// Estado que solo tocan los emisores. Protegido por sem_prod (o por CAS en ANILLO_LOCKFREE).
+struct SeccionProductores {
     int idx_escritura;              // Indice donde escribira el proximo caracter
+    _Atomic long celdas_escritas;   // Celdas escritas desde el inicio (solo ANILLO_SEMAFOROS)
+    struct EstadoRedimension redimension;
+    long idx_archivo_lectura;       // Indice global para la lectura del archivo fuente
+    _Atomic long total_producidos;  // Bytes producidos
+    _Atomic unsigned long pos_encolar;      // Solo ANILLO_LOCKFREE
+    _Atomic int fragmentos_asignados;       // Solo ANILLO_FRAGMENTADO: anillos ya tomados por un emisor
+    struct RegistroDeshacer deshacer;       // Solo SYNC_ROBUSTO: escritura de buffer en curso
+};
+
+// Estado que solo tocan los receptores. Protegido por sem_cons (o por CAS en ANILLO_LOCKFREE).
+struct SeccionConsumidores {
     int idx_lectura;                // Indice donde leera el proximo caracter
+    _Atomic long celdas_leidas;     // Celdas leidas desde el inicio (solo ANILLO_SEMAFOROS)
+    _Atomic long idx_archivo_escritura;     // Indice global para la escritura del archivo final (solo ORDEN_LLEGADA)
+    long fin_salida;                // ORDEN_FUENTE: mayor fin escrito (cada receptor lo junta al darse de baja, con sem_mutex)
+    _Atomic long total_consumidos;  // Bytes consumidos
+    _Atomic unsigned long pos_desencolar;   // Solo ANILLO_LOCKFREE
+    _Atomic int casas_asignadas;            // Solo ANILLO_FRAGMENTADO: receptores con anillo de casa
+    struct RegistroDeshacer deshacer;       // Solo SYNC_ROBUSTO: lectura de buffer en curso
+};
+
+// --- Metricas por trabajador (ver metricas.h) ---
+#define MAX_TRABAJADORES_METRICAS 64    // Ranuras de la tabla; los trabajadores extra no se miden
 
-    int idx_archivo_lectura;        // Indice global para la lectura del archivo fuente
-    int idx_archivo_escritura;      // Indice global para la escritura del archivo final
+#define TRABAJADOR_EMISOR   0
+#define TRABAJADOR_RECEPTOR 1
+
+// Ranura de metricas de un emisor o receptor. Solo la escribe su dueno (sin locks);
+// el monitor la lee en cualquier momento. Cada ranura ocupa sus propias lineas de cache.
+struct MetricasTrabajador {
+    _Alignas(TAM_LINEA_CACHE) _Atomic int pid;  // 0 = ranura libre
+    _Atomic int activo;             // 1 mientras el trabajador corre
+    int tipo;                       // TRABAJADOR_EMISOR o TRABAJADOR_RECEPTOR
+    _Atomic int credito;            // SYNC_ROBUSTO: espacio tomado del anillo (SYNC_EMPTY o SYNC_FULL; 0 = ninguno)
+    _Atomic long bytes;             // Bytes producidos o consumidos
+    _Atomic long unidades;          // Celdas producidas o consumidas
+    _Atomic long ns_bloqueado;      // Tiempo esperando sem_empty (emisor) o sem_full (receptor)
+    _Atomic long bloqueado_desde;   // Inicio de la espera en curso (0 = no esta bloqueado)
+    _Atomic long ns_espera_mutex;   // Tiempo esperando sem_prod / sem_cons
+    _Atomic long ns_retencion_mutex;    // Tiempo con sem_prod / sem_cons tomado
+    _Atomic long muestras_ocupacion;    // Muestras de celdas llenas tomadas
+    _Atomic long suma_ocupacion;    // Suma de las muestras (media = suma / muestras)
+};
+
+// --- Histogramas de latencia de los receptores (ver latencia.h) ---
+// Cubetas logaritmicas estilo HDR: 2^LAT_BITS_SUB sub-cubetas lineales por potencia
+// de dos (error relativo < 1/32). Los valores de mas de 2^(LAT_EXP_MAX+1) ns caen en la ultima.
+#define LAT_BITS_SUB 5
+#define LAT_SUB      (1 << LAT_BITS_SUB)
+#define LAT_EXP_MAX  42
+#define LAT_CUBETAS  (LAT_SUB + (LAT_EXP_MAX - LAT_BITS_SUB + 1) * LAT_SUB)
+#define MAX_RECEPTORES_LATENCIA 16      // Ranuras de la tabla; los receptores extra no se miden
+
+struct HistogramaLatencia {
+    _Atomic long total;             // Muestras registradas
+    _Atomic long suma_ns;
+    _Atomic long maximo_ns;
+    _Atomic long cuentas[LAT_CUBETAS];
+};
+
+// Latencias de un receptor, medidas desde la marca de encolado de cada unidad
+struct LatenciaReceptor {
+    _Alignas(TAM_LINEA_CACHE) _Atomic int pid;  // 0 = ranura libre
+    struct HistogramaLatencia desencolado;      // Encolado -> desencolado
+    struct HistogramaLatencia escritura;        // Encolado -> entregado al archivo de salida
+};
+
+struct MemoriaCompartida {
+    // --- Configuracion (solo lectura despues del inicializador) ---
+    int buffer_size;                // Tamano N del buffer (con redimension solo cambia con sem_prod y sem_cons tomados)
+    int tam_reclamo;                // Bytes del archivo fuente que un emisor reclama por cada toma del lock
+    int modo_lectura;               // LECTURA_MMAP, LECTURA_STDIO o LECTURA_FLUJO
+    int manifiesto;                 // 1 = tabla de trabajos en <shm_id>_trabajos (ver trabajos.h)
+    int orden_salida;               // ORDEN_LLEGADA u ORDEN_FUENTE
+    int checkpoint;                 // 1 = marca de lo escrito en <shm_id>_checkpoint (ver checkpoint.h)
+    long inicio_fuente;             // Primer byte a procesar (> 0 al reanudar desde un checkpoint)
+    int protocolo_anillo;           // ANILLO_SEMAFOROS, ANILLO_LOCKFREE o ANILLO_FRAGMENTADO
+    int num_fragmentos;             // Anillos de ANILLO_FRAGMENTADO (1 en los demas)
+    int celdas_fragmento;           // Celdas de cada anillo (buffer_size = num_fragmentos * celdas_fragmento)
+    int formato_registro;           // REGISTRO_COMPLETO, REGISTRO_COMPACTO o REGISTRO_BLOQUE
+    int tam_bloque;                 // Maximo de bytes por celda en REGISTRO_BLOQUE (1 en los demas)
+    int tam_registro;               // Bytes que ocupa cada celda del buffer
+    time_t tiempo_base;             // Hora real de la inicializacion
+    int64_t base_monotonica_ns;     // CLOCK_MONOTONIC en ese mismo instante (hora = tiempo_base + delta)
+    int backend_sync;               // SYNC_SEMAFOROS, SYNC_FUTEX o SYNC_ROBUSTO
+    int presupuesto_espera;         // Vueltas de giro antes de dormir en SYNC_FUTEX
+    int tipo_paginas;               // PAGINAS_NORMALES, PAGINAS_THP o PAGINAS_HUGETLB
+    int prefault;                   // 1 = cada trabajador prefaltea su mapeo al conectarse
+    long tam_pagina;                // Tamano de pagina efectivo del segmento (bytes)
+    int redimension;                // 1 = el buffer crece y se reduce en linea (ver redimension.h)
+    int buffer_min;                 // Limites del redimensionado (espacios)
+    int buffer_max;
+    size_t tam_mapeo;               // Bytes que mapea cada trabajador (el segmento con buffer_max)
 
     // --- Informacion solicitada ---
     unsigned char llave_desencriptar;
+    int algoritmo_cifrado;          // CIFRADO_XOR o CIFRADO_CHACHA20 (ver cifrado.h)
+    uint32_t clave_chacha[8];       // CIFRADO_CHACHA20: clave de 256 bits
+    uint64_t nonce_chacha;          // CIFRADO_CHACHA20: nonce de la corrida
     char archivo_fuente[256];
 
-    // --- Auditoria ---
-    int total_producidos;
-    int total_consumidos;
-
+    // --- Estado global (protegido por sem_mutex) ---
     volatile int shutdown_flag;     // 1 = Apagar, 0 = Correr
     volatile int emisores_activos;
     volatile int receptores_activos;
     int emisores_totales;
     int receptores_totales;
+    int emisores_hilos;             // 1 = un lanzador --hilos tiene sem_prod privado: no se aceptan otros
+    int receptores_hilos;           // 1 = un lanzador --hilos tiene sem_cons privado: no se aceptan otros
+    int trabajadores_purgados;      // SYNC_ROBUSTO: muertos dados de baja por otro proceso
+
+    // --- Redimensionado (se escribe con sem_prod y sem_cons tomados) ---
+    _Atomic int generacion;         // Aumenta con cada cambio de tamano del buffer
+    int veces_crecido;
+    int veces_reducido;
+
+    // --- Semaforos embebidos (solo SYNC_FUTEX), uno por linea de cache ---
+    struct SemFutex sync_futex[SYNC_TOTAL];
 
+    // --- Semaforos embebidos (solo SYNC_ROBUSTO) ---
+    struct SemRobusto sync_robusto[SYNC_TOTAL];
 
-    // --- Buffer (Array flexible) ---
-    struct CharInfo buffer[]; 
+    // --- Aviso de datos nuevos a los receptores dormidos (solo ANILLO_FRAGMENTADO) ---
+    struct EventoFutex evento_fragmentos;
+
+    // --- Indices y auditoria, cada lado en su propia linea de cache ---
+    _Alignas(TAM_LINEA_CACHE) struct SeccionProductores productores;
+    _Alignas(TAM_LINEA_CACHE) struct SeccionConsumidores consumidores;
+
+    // --- Metricas en vivo, una ranura por trabajador ---
+    struct MetricasTrabajador metricas[MAX_TRABAJADORES_METRICAS];
+
+    // --- Histogramas de latencia, una ranura por receptor ---
+    struct LatenciaReceptor latencias[MAX_RECEPTORES_LATENCIA];
+
+    // --- Buffer (Array flexible de buffer_size celdas de tam_registro bytes) ---
+    _Alignas(TAM_LINEA_CACHE) unsigned char buffer[];
 };
 
 
+// --- Modos de lectura del archivo fuente ---
+#define LECTURA_MMAP  0             // Mapear el archivo (con stdio como respaldo si no es mapeable)
+#define LECTURA_STDIO 1             // Forzar fopen/fgetc
+#define LECTURA_FLUJO 2             // Un proceso lector llena una cola de trozos (ver flujo.h)
+
+// --- Posicion de cada unidad en el archivo de salida ---
+#define ORDEN_LLEGADA 0             // En orden de consumo (idx_archivo_escritura), sin fines de linea
+#define ORDEN_FUENTE  1             // En su offset de la fuente: la salida es una copia exacta, fines de linea incluidos
+
+// --- Algoritmos de cifrado (ver cifrado.h) ---
+#define CIFRADO_XOR      0          // Un byte fijo (llave_desencriptar)
+#define CIFRADO_CHACHA20 1          // Keystream ChaCha20 indexado por el offset de la fuente
+
+// --- Protocolos de acceso al buffer ---
+#define ANILLO_SEMAFOROS 0          // buffer protegido por sem_prod / sem_cons
+#define ANILLO_LOCKFREE  1          // anillo MPMC con secuencias por celda (ver anillo.h)
+#define ANILLO_FRAGMENTADO 2        // un anillo de un solo productor por emisor, con robo (ver fragmentos.h)
+
+// --- Formatos de registro del buffer ---
+#define REGISTRO_COMPLETO 0         // struct CharInfo (16 bytes por caracter)
+#define REGISTRO_COMPACTO 1         // struct CharInfoCompacta (8 bytes por caracter)
+#define REGISTRO_BLOQUE   2         // struct CabeceraBloque + hasta tam_bloque bytes por celda
+
+// --- Backends de sincronizacion ---
+#define SYNC_SEMAFOROS 0            // Semaforos POSIX con nombre
+#define SYNC_FUTEX     1            // Contadores en el segmento + futex(2)
+#define SYNC_ROBUSTO   2            // Mutex robustos pthread en el segmento
+
+// --- Paginas del segmento ---
+#define PAGINAS_NORMALES 0          // Paginas base de tmpfs (/dev/shm)
+#define PAGINAS_THP      1          // tmpfs + madvise(MADV_HUGEPAGE)
+#define PAGINAS_HUGETLB  2          // Archivo en hugetlbfs (DIR_HUGETLBFS) en lugar de shm_open
+
+// --- Valores por defecto ---
+#define TAM_RECLAMO_DEFECTO 4096    // Granularidad de reclamo de trabajo de los emisores (bytes)
+#define TAM_BLOQUE_DEFECTO  4096    // Capacidad de cada celda en REGISTRO_BLOQUE (bytes)
+#define PRESUPUESTO_ESPERA_DEFECTO 200  // Vueltas de giro antes de dormir en SYNC_FUTEX
+#define FRAGMENTOS_DEFECTO  4       // Anillos de ANILLO_FRAGMENTADO si no se indica --fragmentos
+#define TAM_TROZO_DEFECTO   (256 * 1024)    // Bytes por trozo de la cola de LECTURA_FLUJO
+#define TROZOS_DEFECTO      8       // Trozos de la cola de LECTURA_FLUJO (lectura adelantada del lector)
+
 // --- Nombres para recursos IPC ---
 #define SEM_MUTEX_NAME_SUFFIX "_mutex"
+#define SEM_PROD_NAME_SUFFIX "_prod"
+#define SEM_CONS_NAME_SUFFIX "_cons"
 #define SEM_EMPTY_NAME_SUFFIX "_empty"
 #define SEM_FULL_NAME_SUFFIX "_full"
 #define SEM_FIN_NAME_SUFFIX "_fin"
+#define SHM_TROZOS_NAME_SUFFIX "_trozos"    // Segmento de la cola de LECTURA_FLUJO
+#define SHM_TRABAJOS_NAME_SUFFIX "_trabajos"    // Segmento de la tabla de trabajos (--manifiesto)
+#define SHM_CHECKPOINT_NAME_SUFFIX "_checkpoint"    // Segmento de la marca de lo escrito (--checkpoint)
 
 #endif // MEMINFO_H
\ No newline at end of file
@@ -0,0 +1,68 @@
+#ifndef METRICAS_H
+#define METRICAS_H
+
+#include <time.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include "memInfo.h"
+#include "sincronizacion.h"
+
+// Metricas en vivo de cada emisor/receptor en la tabla memoria->metricas.
+// Cada trabajador reclama una ranura al arrancar y solo el la escribe, con
+// sumas atomicas relajadas: no hay locks y el monitor puede leer en cualquier momento.
+
+#define MUESTREO_OCUPACION 64       // Se muestrea la ocupacion del buffer cada N unidades
+
+static inline long metricas_ahora_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long)ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static inline void metricas_sumar(_Atomic long *contador, long valor) {
+    atomic_fetch_add_explicit(contador, valor, memory_order_relaxed);
+}
+
+// La espera en sem_empty/sem_full se publica al empezar para que el monitor vea
+// tambien las esperas largas que aun no terminaron
+static inline long metricas_bloqueo_inicio(struct MetricasTrabajador *m) {
+    long t = metricas_ahora_ns();
+    atomic_store_explicit(&m->bloqueado_desde, t, memory_order_relaxed);
+    return t;
+}
+
+static inline void metricas_bloqueo_fin(struct MetricasTrabajador *m, long desde) {
+    metricas_sumar(&m->ns_bloqueado, metricas_ahora_ns() - desde);
+    atomic_store_explicit(&m->bloqueado_desde, 0, memory_order_relaxed);
+}
+
+// Reclama una ranura libre; si la tabla esta llena se devuelve una ranura local descartable
+static inline struct MetricasTrabajador *metricas_registrar(struct MemoriaCompartida *memoria, int tipo) {
+    static struct MetricasTrabajador descartada;
+    for (int i = 0; i < MAX_TRABAJADORES_METRICAS; i++) {
+        int libre = 0;
+        if (atomic_compare_exchange_strong(&memoria->metricas[i].pid, &libre, id_trabajador())) {
+            struct MetricasTrabajador *m = &memoria->metricas[i];
+            m->tipo = tipo;
+            atomic_store(&m->activo, 1);
+            return m;
+        }
+    }
+    return &descartada;
+}
+
+static inline void metricas_terminar(struct MetricasTrabajador *m) {
+    atomic_store(&m->activo, 0);
+}
+
+// Contabiliza una unidad transferida y, cada MUESTREO_OCUPACION unidades, las celdas llenas
+static inline void metricas_unidad(struct MetricasTrabajador *m, int bytes, struct Semaforo *full) {
+    metricas_sumar(&m->bytes, bytes);
+    long unidades = atomic_fetch_add_explicit(&m->unidades, 1, memory_order_relaxed) + 1;
+    if (unidades % MUESTREO_OCUPACION == 0) {
+        metricas_sumar(&m->suma_ocupacion, semaforo_valor(full));
+        metricas_sumar(&m->muestras_ocupacion, 1);
+    }
+}
+
+#endif // METRICAS_H
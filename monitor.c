@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>     // Para signal() y SIGINT
+#include <time.h>       // Para nanosleep
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "memInfo.h"
+#include "segmento.h"
+#include "metricas.h"
+
+#define ANSI_COLOR_BLUE    "\x1b[34m"
+#define ANSI_COLOR_CYAN    "\x1b[36m"
+#define ANSI_COLOR_YELLOW  "\x1b[33m"
+#define ANSI_COLOR_RESET   "\x1b[0m"
+
+#define INTERVALO_DEFECTO_MS 1000
+
+// Monitor en vivo: lee la tabla de metricas del segmento a intervalos fijos e imprime
+// tasas y contencion por trabajador. Nunca toma semaforos, asi que no frena al pipeline.
+
+static volatile sig_atomic_t salir = 0;
+
+void reportar_error_y_salir(const char *msg) {
+    perror(msg);
+    exit(EXIT_FAILURE);
+}
+
+void manejador_sigint(int sig) {
+    salir = 1;
+}
+
+// Copia de los contadores de una ranura en un instante
+struct Muestra {
+    long bytes, unidades, ns_bloqueado, ns_espera_mutex, ns_retencion_mutex, muestras_ocupacion, suma_ocupacion;
+};
+
+static void tomar_muestra(const struct MetricasTrabajador *m, struct Muestra *s, long ahora) {
+    s->bytes = atomic_load_explicit(&m->bytes, memory_order_relaxed);
+    s->unidades = atomic_load_explicit(&m->unidades, memory_order_relaxed);
+    // La espera en curso cuenta hasta ahora; cuando termine ya estara en ns_bloqueado
+    long desde = atomic_load_explicit(&m->bloqueado_desde, memory_order_relaxed);
+    s->ns_bloqueado = atomic_load_explicit(&m->ns_bloqueado, memory_order_relaxed);
+    if (desde != 0 && desde < ahora) s->ns_bloqueado += ahora - desde;
+    s->ns_espera_mutex = atomic_load_explicit(&m->ns_espera_mutex, memory_order_relaxed);
+    s->ns_retencion_mutex = atomic_load_explicit(&m->ns_retencion_mutex, memory_order_relaxed);
+    s->muestras_ocupacion = atomic_load_explicit(&m->muestras_ocupacion, memory_order_relaxed);
+    s->suma_ocupacion = atomic_load_explicit(&m->suma_ocupacion, memory_order_relaxed);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2 && !(argc == 4 && strcmp(argv[2], "--intervalo") == 0)) {
+        fprintf(stderr, "Uso: %s <shm_id> [--intervalo <ms>]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    const char *shm_name = argv[1];
+    long intervalo_ms = argc == 4 ? atol(argv[3]) : INTERVALO_DEFECTO_MS;
+    if (intervalo_ms <= 0) {
+        fprintf(stderr, "Error: El intervalo debe ser mayor que 0.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Conectar a la memoria en solo lectura ---
+    int shm_fd = segmento_abrir(shm_name, O_RDONLY);
+    if (shm_fd == -1) reportar_error_y_salir("Error en shm_open");
+    const struct MemoriaCompartida *memoria = mmap(NULL, sizeof(struct MemoriaCompartida), PROT_READ, MAP_SHARED, shm_fd, 0);
+    if (memoria == MAP_FAILED) reportar_error_y_salir("mmap");
+    close(shm_fd);
+
+    signal(SIGINT, manejador_sigint);
+
+    struct Muestra anterior[MAX_TRABAJADORES_METRICAS];
+    memset(anterior, 0, sizeof(anterior));
+    long t_anterior = metricas_ahora_ns();
+    long t_inicio = t_anterior;
+    struct timespec pausa = { intervalo_ms / 1000, (intervalo_ms % 1000) * 1000000L };
+
+    printf("Monitor (PID: %d) para SHM: %s cada %ld ms. Ctrl+C para salir.\n", getpid(), shm_name, intervalo_ms);
+
+    while (!salir) {
+        nanosleep(&pausa, NULL);
+        long t_actual = metricas_ahora_ns();
+        double dt_ns = (double)(t_actual - t_anterior);
+        t_anterior = t_actual;
+
+        long en_buffer = atomic_load(&memoria->productores.total_producidos) - atomic_load(&memoria->consumidores.total_consumidos);
+        printf("\n" ANSI_COLOR_YELLOW "[t=%7.1fs]" ANSI_COLOR_RESET " Emisores: %d/%d | Receptores: %d/%d | Bytes en buffer: %ld\n",
+               (t_actual - t_inicio) / 1e9, memoria->emisores_activos, memoria->emisores_totales,
+               memoria->receptores_activos, memoria->receptores_totales, en_buffer);
+        if (memoria->redimension) {
+            printf("Buffer: %d espacios (generacion %d, rango %d..%d)\n", memoria->buffer_size,
+                   atomic_load(&memoria->generacion), memoria->buffer_min, memoria->buffer_max);
+        }
+        printf("%-10s %-8s %-6s %12s %10s %8s %9s %9s %10s\n",
+               "TIPO", "PID", "VIVO", "BYTES/s", "UNID/s", "BLOQ%", "ESP.MTX%", "RET.MTX%", "OCUP.MEDIA");
+
+        for (int i = 0; i < MAX_TRABAJADORES_METRICAS; i++) {
+            const struct MetricasTrabajador *m = &memoria->metricas[i];
+            int pid = atomic_load(&m->pid);
+            if (pid == 0) continue;
+
+            struct Muestra actual;
+            tomar_muestra(m, &actual, t_actual);
+            struct Muestra *prev = &anterior[i];
+            long muestras = actual.muestras_ocupacion - prev->muestras_ocupacion;
+            double ocupacion = muestras > 0 ? (double)(actual.suma_ocupacion - prev->suma_ocupacion) / muestras : 0.0;
+
+            printf("%s%-10s" ANSI_COLOR_RESET " %-8d %-6s %12.0f %10.0f %7.1f%% %8.1f%% %8.1f%% %10.1f\n",
+                   m->tipo == TRABAJADOR_EMISOR ? ANSI_COLOR_CYAN : ANSI_COLOR_BLUE,
+                   m->tipo == TRABAJADOR_EMISOR ? "EMISOR" : "RECEPTOR", pid,
+                   atomic_load(&m->activo) ? "si" : "no",
+                   (actual.bytes - prev->bytes) * 1e9 / dt_ns,
+                   (actual.unidades - prev->unidades) * 1e9 / dt_ns,
+                   100.0 * (actual.ns_bloqueado - prev->ns_bloqueado) / dt_ns,
+                   100.0 * (actual.ns_espera_mutex - prev->ns_espera_mutex) / dt_ns,
+                   100.0 * (actual.ns_retencion_mutex - prev->ns_retencion_mutex) / dt_ns,
+                   ocupacion);
+            *prev = actual;
+        }
+        fflush(stdout);
+
+        // Tras el cierre elegante ya no queda nada que observar
+        if (memoria->shutdown_flag && memoria->emisores_activos == 0 && memoria->receptores_activos == 0) break;
+    }
+
+    munmap((void *)memoria, sizeof(struct MemoriaCompartida));
+    return EXIT_SUCCESS;
+}
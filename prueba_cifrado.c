@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cifrado_xor.h"
+
+// Prueba de los kernels XOR (make test-cifrado): cada variante que la CPU soporta
+// debe dejar exactamente los mismos bytes que xor_escalar, para las 256 claves,
+// todas las longitudes hasta 5 vectores de 64 bytes (cada resto posible de cada
+// ancho) mas algunas largas, y todas las desalineaciones de 0 a 63, sin tocar nada
+// fuera del rango. Sale con 1 si alguna no coincide.
+
+#define PRUEBA_LEN_CORTA 320            // Se prueban todas las longitudes 0..PRUEBA_LEN_CORTA
+#define PRUEBA_GUARDA    64             // Bytes despues del rango que no deben cambiar
+#define PRUEBA_TAM (64 + 1024 + PRUEBA_GUARDA)
+
+static const size_t LONGITUDES_LARGAS[] = { 511, 512, 513, 1000, 1023, 1024 };
+
+// Devuelve la cantidad de casos que no coinciden
+static long probar_variante(FuncionXor variante) {
+    static unsigned char base[PRUEBA_TAM], esperado[PRUEBA_TAM], obtenido[PRUEBA_TAM];
+    long fallos = 0;
+    for (int clave = 0; clave < 256; clave++) {
+        for (size_t i = 0; i < PRUEBA_TAM; i++) base[i] = (unsigned char)(i * 31 + clave);
+        for (size_t desfase = 0; desfase < 64; desfase++) {
+            size_t n_largas = sizeof(LONGITUDES_LARGAS) / sizeof(LONGITUDES_LARGAS[0]);
+            for (size_t l = 0; l <= PRUEBA_LEN_CORTA + n_largas; l++) {
+                size_t len = l <= PRUEBA_LEN_CORTA ? l : LONGITUDES_LARGAS[l - PRUEBA_LEN_CORTA - 1];
+                size_t tam = desfase + len + PRUEBA_GUARDA;
+                memcpy(esperado, base, tam);
+                memcpy(obtenido, base, tam);
+                xor_escalar(esperado + desfase, len, (unsigned char)clave);
+                variante(obtenido + desfase, len, (unsigned char)clave);
+                if (memcmp(esperado, obtenido, tam) != 0) {
+                    if (fallos == 0) fprintf(stderr, "  primer fallo: clave %d, desfase %zu, longitud %zu\n", clave, desfase, len);
+                    fallos++;
+                }
+            }
+        }
+    }
+    return fallos;
+}
+
+int main(void) {
+    struct VarianteXor variantes[XOR_MAX_VARIANTES];
+    int n = xor_variantes(variantes);
+    int probadas = 0, malas = 0;
+    for (int i = 0; i < n; i++) {
+        if (!variantes[i].soportada) {
+            printf("xor %-7s no soportada por esta CPU\n", variantes[i].nombre);
+            continue;
+        }
+        long fallos = probar_variante(variantes[i].funcion);
+        printf("xor %-7s %s", variantes[i].nombre, fallos == 0 ? "ok\n" : "FALLA");
+        if (fallos != 0) printf(" (%ld casos)\n", fallos);
+        probadas++;
+        if (fallos != 0) malas++;
+    }
+    printf("%d variantes probadas, %d con diferencias; kernel elegido: %s\n", probadas, malas,
+           (xor_kernel(), xor_nombre));
+    return malas == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,3 +1,4 @@
+#define _GNU_SOURCE     // Para sched_setaffinity (afinidad.h)
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -6,11 +7,27 @@
 #include <sys/mman.h>   // Para shm_opne, mmap
 #include <sys/stat.h>   // Para fstat
 #include <sys/wait.h>   // Para wait
-#include <semaphore.h>  // Para sem_open, sem_wait, sem_post
 #include <time.h>       // Para time, strftime
 #include <ctype.h>      // Para isprint
 #include <errno.h>      // Para errno, EINTR
+#include <sched.h>      // Para sched_yield
+#include <pthread.h>    // Para el modo --hilos
 #include "memInfo.h"    // Archivo de cabecera
+#include "registro.h"   // Formato de las celdas del buffer
+#include "anillo.h"     // Anillo sin locks
+#include "fragmentos.h" // Anillos por emisor con robo
+#include "sincronizacion.h" // Semaforos POSIX o futex
+#include "cifrado.h"    // XOR o ChaCha20 por offset, con kernels vectorizados
+#include "bitacora.h"   // Bitacora binaria del modo silencioso
+#include "metricas.h"   // Metricas en vivo por trabajador
+#include "latencia.h"   // Histogramas de latencia
+#include "afinidad.h"   // Fijacion de trabajadores a CPUs
+#include "segmento.h"   // Apertura del segmento (shm o hugetlbfs)
+#include "redimension.h" // Buffer que crece y se reduce en linea
+#include "uring.h"      // io_uring sin liburing para SALIDA_URING
+#include "trabajos.h"   // Tabla de trabajos de --manifiesto
+#include "checkpoint.h" // Marca de lo escrito (--checkpoint)
+#include <sys/uio.h>    // Para pwritev (respaldo de SALIDA_URING)
 
 // --- Codigos de color ANSI para la impresion elegante
 #define ANSI_COLOR_BLUE     "\x1b[34m"    
@@ -25,168 +42,892 @@ void reportar_error_y_salir(const char *msg) {
     exit(EXIT_FAILURE);
 }
 
-// Imprime de forma tabular y con colores la informacion del caracter producido
-void imprimir_produccion(const struct CharInfo* info, char char_original) {
+// Imprime de forma tabular y con colores la informacion del caracter (o bloque) consumido
+// 'info' ya viene decodificado
+void imprimir_produccion(const struct MemoriaCompartida *memoria, const struct Bloque* info, unsigned char clave) {
     char time_str[64];
-    strftime(time_str, sizeof(time_str), "%H:%M:%S", localtime(&info->timestamp));
-    char original_printable = isprint(char_original) ? char_original : '?';
-    char cifrado_printable = isprint(info->valor_ascii) ? info->valor_ascii : '?';
+    time_t hora = registro_hora(memoria, info->t_encolado_ns);
+    strftime(time_str, sizeof(time_str), "%H:%M:%S", localtime(&hora));
 
     const char* colors[] = { ANSI_COLOR_BLUE, ANSI_COLOR_GREEN, ANSI_COLOR_YELLOW, ANSI_COLOR_RED };
-    const char* color = colors[getpid() % 4];   // Elige un color basado en el PID
+    const char* color = colors[id_trabajador() % 4];   // Elige un color basado en el TID
 
     /* Use a literal format string to avoid -Wformat-security warnings */
-    printf("%s[RECEPTOR (PID: %d)]%s -> | ", color, getpid(), ANSI_COLOR_RESET);
-    printf("Original: " ANSI_COLOR_YELLOW "'%c'" ANSI_COLOR_RESET " | ", original_printable);
-    printf("Cifrado: " ANSI_COLOR_GREEN "'%c' (0x%02X)" ANSI_COLOR_RESET " | ", cifrado_printable, (unsigned char)info->valor_ascii);
+    printf("%s[RECEPTOR (PID: %d)]%s -> | ", color, id_trabajador(), ANSI_COLOR_RESET);
+    if (info->longitud == 1) {
+        unsigned char cifrado = info->datos[0] ^ clave;
+        char original_printable = isprint(info->datos[0]) ? (char)info->datos[0] : '?';
+        char cifrado_printable = isprint(cifrado) ? (char)cifrado : '?';
+        printf("Original: " ANSI_COLOR_YELLOW "'%c'" ANSI_COLOR_RESET " | ", original_printable);
+        printf("Cifrado: " ANSI_COLOR_GREEN "'%c' (0x%02X)" ANSI_COLOR_RESET " | ", cifrado_printable, cifrado);
+    } else {
+        printf("Bloque: " ANSI_COLOR_YELLOW "%d bytes" ANSI_COLOR_RESET " | ", info->longitud);
+        printf("Offset: " ANSI_COLOR_GREEN "%ld" ANSI_COLOR_RESET " | ", info->offset_fuente);
+    }
     /* Print index with matching format and argument */
     printf("Indice: %-4d | ", info->indice);
     printf("Hora: %s |\n", time_str);
 }
 
-void receptor_worker(const char* shm_name, const char* modo_ejecucion, const char* archivo_salida_nombre) {
-    // Validar modo
-    int modo_manual = 0;
-    if (strcmp(modo_ejecucion, "manual") == 0) {
-        modo_manual = 1;
-        printf (ANSI_COLOR_BLUE "[WORKER (PID: %d)] Modo: Manual\n" ANSI_COLOR_RESET, getpid());
-    } else if (strcmp(modo_ejecucion, "automatico") != 0) {
-        fprintf(stderr, "[ERROR (PID %d)]: Modo debe ser 'manual' o 'automatico'.\n", getpid());
-        exit(EXIT_FAILURE);
+// --- Motores de escritura del archivo de salida ---
+#define SALIDA_STDIO  0     // fseek + fputc + fflush por caracter (comportamiento original)
+#define SALIDA_PWRITE 1     // Escrituras posicionales agrupadas en rangos contiguos
+#define SALIDA_MMAP   2     // Archivo pre-dimensionado y mapeado de forma compartida
+#define SALIDA_URING  3     // Rangos contiguos enviados por lotes a io_uring, varios en vuelo
+
+#define FLUSH_SALIDA_DEFECTO (64 * 1024)    // Bytes entre vaciados del motor de salida
+#define EXTENSION_SALIDA     (1024 * 1024)  // Crecimiento del archivo mapeado si no se conoce su tamano
+#define EN_VUELO_DEFECTO     8              // SALIDA_URING: buffers de intervalo_flush bytes por receptor
+#define IOV_LOTE             64             // Maximo de buffers por pwritev en el respaldo sin io_uring
+
+// SALIDA_URING: cada buffer acumula un rango contiguo y pasa por
+// LIBRE -> LLENANDO -> SELLADO (espera su lote) -> EN_VUELO (en el kernel) -> LIBRE
+#define BUFFER_LIBRE     0
+#define BUFFER_LLENANDO  1
+#define BUFFER_SELLADO   2
+#define BUFFER_EN_VUELO  3
+
+struct BufferSalida {
+    unsigned char *datos;
+    long inicio;
+    size_t len;
+    int estado;
+    long *marcas;                   // Marcas de encolado de sus unidades (se entregan al completarse)
+    size_t n_marcas;
+    size_t cap_marcas;
+};
+
+struct SalidaReceptor {
+    int modo;
+    size_t intervalo_flush;         // Bytes a acumular antes de vaciar
+
+    FILE *archivo;                  // SALIDA_STDIO
+
+    int fd;                         // SALIDA_PWRITE y SALIDA_MMAP
+    unsigned char *pendiente;       // SALIDA_PWRITE: rango contiguo aun no escrito
+    long pendiente_inicio;
+    size_t pendiente_len;
+
+    unsigned char *mapa;            // SALIDA_MMAP
+    size_t tam_mapa;
+    size_t sucio_desde;             // Primer byte mapeado no sincronizado
+    size_t sucio_hasta;
+
+    struct Uring *uring;            // SALIDA_URING (NULL = io_uring no disponible: respaldo con pwritev)
+    struct BufferSalida *buffers;
+    int num_buffers;
+    int lote;                       // Buffers sellados que se envian juntos en una syscall
+    int actual;                     // Buffer que se esta llenando (-1 = ninguno)
+    int *sellados;                  // Indices de los buffers sellados, en orden de sellado
+    int n_sellados;
+    int en_vuelo;
+
+    int compartida;                 // 1 = fd/FILE del lanzador (modo hilos): no se cierran aqui
+
+    struct HistogramaLatencia *latencia;    // Encolado -> entregado al archivo (NULL = no medir)
+    long *marcas;                   // Marcas de encolado de lo aun no entregado
+    size_t n_marcas;
+    size_t cap_marcas;
+
+    struct Checkpoint *checkpoint;  // Cuenta cada rango al llegar al archivo (NULL = sin --checkpoint)
+};
+
+// Abre el archivo de salida (fd o FILE segun el modo) sin crear buffers ni mapeos
+void salida_abrir_archivo(struct SalidaReceptor *salida, const char *ruta, int modo, size_t intervalo_flush,
+                          int num_buffers) {
+    memset(salida, 0, sizeof(*salida));
+    salida->modo = modo;
+    salida->intervalo_flush = intervalo_flush;
+    salida->num_buffers = num_buffers;
+    salida->fd = -1;
+    salida->actual = -1;
+
+    if (modo == SALIDA_STDIO) {
+        salida->archivo = fopen(ruta, "r+");
+        if (salida->archivo == NULL) {
+            fprintf(stderr, "Error (PID %d) al abrir el archivo salida: %s\n", getpid(), ruta);
+            reportar_error_y_salir("fopen");
+        }
+        return;
+    }
+
+    salida->fd = open(ruta, O_RDWR);
+    if (salida->fd == -1) {
+        fprintf(stderr, "Error (PID %d) al abrir el archivo salida: %s\n", getpid(), ruta);
+        reportar_error_y_salir("open");
     }
+}
 
-    // --- Generar Nombres de Semaforos ---
-    char sem_mutex_name[512], sem_empty_name[512], sem_full_name[512], sem_fin_name[512];
-    int r;
-    r = snprintf(sem_mutex_name, sizeof(sem_mutex_name), "%s%s", shm_name, SEM_MUTEX_NAME_SUFFIX);
-    if (r < 0 || (size_t)r >= sizeof(sem_mutex_name)) reportar_error_y_salir("sem name snprintf (mutex) truncated");
-    r = snprintf(sem_empty_name, sizeof(sem_empty_name), "%s%s", shm_name, SEM_EMPTY_NAME_SUFFIX);
-    if (r < 0 || (size_t)r >= sizeof(sem_empty_name)) reportar_error_y_salir("sem name snprintf (empty) truncated");
-    r = snprintf(sem_full_name, sizeof(sem_full_name), "%s%s", shm_name, SEM_FULL_NAME_SUFFIX);
-    if (r < 0 || (size_t)r >= sizeof(sem_full_name)) reportar_error_y_salir("sem name snprintf (full) truncated");
-    r = snprintf(sem_fin_name, sizeof(sem_fin_name), "%s%s", shm_name, SEM_FIN_NAME_SUFFIX);
-    if (r < 0 || (size_t)r >= sizeof(sem_fin_name)) reportar_error_y_salir("sem name snprintf (fin) truncated");
+// Crea el estado propio de un receptor sobre el archivo ya abierto
+void salida_preparar(struct SalidaReceptor *salida) {
+    if (salida->modo == SALIDA_STDIO) return;
 
-    // --- Conectar a los Recursos IPC ---
-    sem_t *sem_mutex = sem_open(sem_mutex_name, 0);
-    if (sem_mutex == SEM_FAILED) reportar_error_y_salir("Error en sem_open (mutex)");
-    sem_t *sem_empty = sem_open(sem_empty_name, 0);
-    if (sem_empty == SEM_FAILED) reportar_error_y_salir("Error en sem_open (empty)");
-    sem_t *sem_full = sem_open(sem_full_name, 0);
-    if (sem_full == SEM_FAILED) reportar_error_y_salir("Error en sem_open (full)");
-    sem_t *sem_fin = sem_open(sem_fin_name, 0);
-    if (sem_fin == SEM_FAILED) reportar_error_y_salir("Error en sem_open (fin)");
-
-    int shm_fd = shm_open(shm_name, O_RDWR, 0666);
+    if (salida->modo == SALIDA_PWRITE) {
+        salida->pendiente = malloc(salida->intervalo_flush);
+        if (salida->pendiente == NULL) reportar_error_y_salir("malloc (salida)");
+        return;
+    }
+
+    if (salida->modo == SALIDA_URING) {
+        salida->buffers = calloc(salida->num_buffers, sizeof(struct BufferSalida));
+        salida->sellados = malloc(salida->num_buffers * sizeof(int));
+        if (salida->buffers == NULL || salida->sellados == NULL) reportar_error_y_salir("malloc (salida)");
+        for (int i = 0; i < salida->num_buffers; i++) {
+            salida->buffers[i].datos = malloc(salida->intervalo_flush);
+            if (salida->buffers[i].datos == NULL) reportar_error_y_salir("malloc (salida)");
+        }
+        salida->lote = salida->num_buffers / 2 > 0 ? salida->num_buffers / 2 : 1;
+        salida->actual = -1;
+
+        // Un anillo por receptor (hijo o hilo): nunca tiene mas de num_buffers escrituras en vuelo
+        salida->uring = malloc(sizeof(struct Uring));
+        if (salida->uring == NULL) reportar_error_y_salir("malloc (uring)");
+        if (uring_crear(salida->uring, salida->num_buffers) == -1) {
+            free(salida->uring);
+            salida->uring = NULL;
+        }
+        return;
+    }
+
+    // SALIDA_MMAP: mapear el tamano que el lanzador ya reservo (o una primera extension)
+    struct stat salida_stat;
+    if (fstat(salida->fd, &salida_stat) == -1) reportar_error_y_salir("fstat (salida)");
+    salida->tam_mapa = salida_stat.st_size;
+    if (salida->tam_mapa == 0) {
+        salida->tam_mapa = EXTENSION_SALIDA;
+        int err = posix_fallocate(salida->fd, 0, salida->tam_mapa);
+        if (err != 0) { errno = err; reportar_error_y_salir("posix_fallocate (salida)"); }
+    }
+    salida->mapa = mmap(NULL, salida->tam_mapa, PROT_READ | PROT_WRITE, MAP_SHARED, salida->fd, 0);
+    if (salida->mapa == MAP_FAILED) reportar_error_y_salir("mmap (salida)");
+    salida->sucio_desde = salida->tam_mapa;
+}
+
+void salida_abrir(struct SalidaReceptor *salida, const char *ruta, int modo, size_t intervalo_flush, int num_buffers) {
+    salida_abrir_archivo(salida, ruta, modo, intervalo_flush, num_buffers);
+    salida_preparar(salida);
+}
+
+// Modo hilos: usa el fd (o FILE) abierto por el lanzador y solo crea buffers/mapeo propios
+void salida_abrir_compartida(struct SalidaReceptor *salida, const struct SalidaReceptor *base) {
+    memset(salida, 0, sizeof(*salida));
+    salida->modo = base->modo;
+    salida->intervalo_flush = base->intervalo_flush;
+    salida->num_buffers = base->num_buffers;
+    salida->fd = base->fd;
+    salida->archivo = base->archivo;
+    salida->actual = -1;
+    salida->compartida = 1;
+    salida_preparar(salida);
+}
+
+// pwrite que reintenta hasta escribir todo el rango
+void escribir_completo(int fd, const unsigned char *datos, size_t len, long posicion) {
+    size_t escritos = 0;
+    while (escritos < len) {
+        ssize_t n = pwrite(fd, datos + escritos, len - escritos, posicion + escritos);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            reportar_error_y_salir("pwrite (archivo salida)");
+        }
+        escritos += n;
+    }
+}
+
+// Registra la latencia de las unidades ya entregadas al archivo
+void salida_entregar_marcas(struct SalidaReceptor *salida) {
+    if (salida->n_marcas == 0) return;
+    long ahora = metricas_ahora_ns();
+    for (size_t i = 0; i < salida->n_marcas; i++) latencia_registrar(salida->latencia, ahora - salida->marcas[i]);
+    salida->n_marcas = 0;
+}
+
+// Anota la marca de una unidad que queda pendiente hasta el proximo vaciado
+void salida_anotar_marca(struct SalidaReceptor *salida, long t_encolado_ns) {
+    if (salida->latencia == NULL) return;
+    if (salida->n_marcas == salida->cap_marcas) {
+        salida->cap_marcas = salida->cap_marcas ? salida->cap_marcas * 2 : 1024;
+        salida->marcas = realloc(salida->marcas, salida->cap_marcas * sizeof(long));
+        if (salida->marcas == NULL) reportar_error_y_salir("realloc (marcas)");
+    }
+    salida->marcas[salida->n_marcas++] = t_encolado_ns;
+}
+
+// --- SALIDA_URING ---
+
+// Un buffer ya llego al archivo: registra la latencia de sus unidades y lo libera
+void uring_completar(struct SalidaReceptor *salida, struct BufferSalida *b) {
+    checkpoint_registrar(salida->checkpoint, b->inicio, b->len);
+    if (b->n_marcas > 0) {
+        long ahora = metricas_ahora_ns();
+        for (size_t i = 0; i < b->n_marcas; i++) latencia_registrar(salida->latencia, ahora - b->marcas[i]);
+        b->n_marcas = 0;
+    }
+    b->len = 0;
+    b->estado = BUFFER_LIBRE;
+}
+
+// Procesa los completados disponibles sin bloquear
+void uring_cosechar_todos(struct SalidaReceptor *salida) {
+    struct io_uring_cqe cqe;
+    while (salida->en_vuelo > 0 && uring_cosechar(salida->uring, &cqe)) {
+        struct BufferSalida *b = &salida->buffers[cqe.user_data];
+        if (cqe.res < 0) {
+            errno = -cqe.res;
+            reportar_error_y_salir("io_uring (escritura salida)");
+        }
+        // Escritura corta: el resto se completa de forma sincrona
+        if ((size_t)cqe.res < b->len) {
+            escribir_completo(salida->fd, b->datos + cqe.res, b->len - cqe.res, b->inicio + cqe.res);
+        }
+        salida->en_vuelo--;
+        uring_completar(salida, b);
+    }
+}
+
+// Respaldo sin io_uring: cada corrida de buffers sellados contiguos en el archivo
+// sale con un solo pwritev
+void uring_respaldo_pwritev(struct SalidaReceptor *salida) {
+    struct iovec iov[IOV_LOTE];
+    int i = 0;
+    while (i < salida->n_sellados) {
+        struct BufferSalida *primero = &salida->buffers[salida->sellados[i]];
+        long fin = primero->inicio;
+        size_t total = 0;
+        int n = 0;
+        while (i + n < salida->n_sellados && n < (int)(sizeof(iov) / sizeof(iov[0]))) {
+            struct BufferSalida *b = &salida->buffers[salida->sellados[i + n]];
+            if (b->inicio != fin) break;
+            iov[n].iov_base = b->datos;
+            iov[n].iov_len = b->len;
+            fin += b->len;
+            total += b->len;
+            n++;
+        }
+
+        ssize_t escritos = pwritev(salida->fd, iov, n, primero->inicio);
+        while (escritos == -1 && errno == EINTR) escritos = pwritev(salida->fd, iov, n, primero->inicio);
+        if (escritos == -1) reportar_error_y_salir("pwritev (archivo salida)");
+        // Escritura corta: el resto buffer por buffer
+        size_t hecho = escritos;
+        for (int j = 0; j < n && hecho < total; j++) {
+            struct BufferSalida *b = &salida->buffers[salida->sellados[i + j]];
+            if (hecho >= (size_t)(b->inicio - primero->inicio) + b->len) continue;
+            size_t ya = hecho > (size_t)(b->inicio - primero->inicio) ? hecho - (b->inicio - primero->inicio) : 0;
+            escribir_completo(salida->fd, b->datos + ya, b->len - ya, b->inicio + ya);
+        }
+
+        for (int j = 0; j < n; j++) uring_completar(salida, &salida->buffers[salida->sellados[i + j]]);
+        i += n;
+    }
+    salida->n_sellados = 0;
+}
+
+// Envia todos los buffers sellados con una sola syscall (o con pwritev si no hay io_uring)
+void uring_enviar_lote(struct SalidaReceptor *salida) {
+    if (salida->n_sellados == 0) return;
+    if (salida->uring == NULL) {
+        uring_respaldo_pwritev(salida);
+        return;
+    }
+    for (int i = 0; i < salida->n_sellados; i++) {
+        int indice = salida->sellados[i];
+        struct BufferSalida *b = &salida->buffers[indice];
+        uring_preparar_escritura(salida->uring, salida->fd, b->datos, b->len, b->inicio, indice);
+        b->estado = BUFFER_EN_VUELO;
+    }
+    salida->en_vuelo += salida->n_sellados;
+    salida->n_sellados = 0;
+    if (uring_enviar(salida->uring, 0) == -1) reportar_error_y_salir("io_uring_enter (salida)");
+}
+
+// Cierra el buffer que se esta llenando; sus marcas viajan con el hasta completarse
+void uring_sellar(struct SalidaReceptor *salida) {
+    if (salida->actual < 0) return;
+    struct BufferSalida *b = &salida->buffers[salida->actual];
+    salida->actual = -1;
+    if (b->len == 0) {
+        b->estado = BUFFER_LIBRE;
+        return;
+    }
+
+    long *marcas = b->marcas;
+    size_t cap = b->cap_marcas;
+    b->marcas = salida->marcas;
+    b->n_marcas = salida->n_marcas;
+    b->cap_marcas = salida->cap_marcas;
+    salida->marcas = marcas;
+    salida->n_marcas = 0;
+    salida->cap_marcas = cap;
+
+    b->estado = BUFFER_SELLADO;
+    salida->sellados[salida->n_sellados++] = b - salida->buffers;
+    if (salida->n_sellados >= salida->lote) uring_enviar_lote(salida);
+}
+
+// Devuelve un buffer libre. Solo bloquea si todos estan sellados o en vuelo.
+struct BufferSalida *uring_buffer_libre(struct SalidaReceptor *salida) {
+    for (;;) {
+        if (salida->uring != NULL) uring_cosechar_todos(salida);
+        for (int i = 0; i < salida->num_buffers; i++) {
+            if (salida->buffers[i].estado == BUFFER_LIBRE) {
+                salida->actual = i;
+                salida->buffers[i].estado = BUFFER_LLENANDO;
+                return &salida->buffers[i];
+            }
+        }
+        uring_enviar_lote(salida);
+        if (salida->uring != NULL && salida->en_vuelo > 0 && uring_enviar(salida->uring, 1) == -1) {
+            reportar_error_y_salir("io_uring_enter (espera salida)");
+        }
+    }
+}
+
+// Envia todo lo acumulado y espera a que llegue al archivo
+void uring_drenar(struct SalidaReceptor *salida) {
+    // El archivo base del modo hilos no tiene buffers propios: no hay nada que drenar
+    if (salida->buffers == NULL) return;
+    uring_sellar(salida);
+    uring_enviar_lote(salida);
+    while (salida->en_vuelo > 0) {
+        if (uring_enviar(salida->uring, 1) == -1) reportar_error_y_salir("io_uring_enter (drenar salida)");
+        uring_cosechar_todos(salida);
+    }
+}
+
+// Escribe el rango pendiente con un solo pwrite (o sincroniza la parte sucia del mapeo)
+void salida_vaciar(struct SalidaReceptor *salida) {
+    if (salida->modo == SALIDA_PWRITE) {
+        escribir_completo(salida->fd, salida->pendiente, salida->pendiente_len, salida->pendiente_inicio);
+        checkpoint_registrar(salida->checkpoint, salida->pendiente_inicio, salida->pendiente_len);
+        salida->pendiente_len = 0;
+    } else if (salida->modo == SALIDA_URING) {
+        uring_drenar(salida);
+    } else if (salida->modo == SALIDA_MMAP && salida->sucio_desde < salida->sucio_hasta) {
+        // msync exige una direccion alineada a pagina
+        long pagina = sysconf(_SC_PAGESIZE);
+        size_t desde = salida->sucio_desde - (salida->sucio_desde % pagina);
+        if (msync(salida->mapa + desde, salida->sucio_hasta - desde, MS_ASYNC) == -1) reportar_error_y_salir("msync");
+        salida->sucio_desde = salida->tam_mapa;
+        salida->sucio_hasta = 0;
+    }
+    salida_entregar_marcas(salida);
+}
+
+// Agranda el mapeo por extensiones. posix_fallocate nunca reduce el archivo,
+// por lo que es seguro aunque otros receptores lo hayan agrandado antes.
+void salida_crecer(struct SalidaReceptor *salida, size_t minimo) {
+    salida_vaciar(salida);
+    size_t nuevo_tam = ((minimo + EXTENSION_SALIDA - 1) / EXTENSION_SALIDA) * EXTENSION_SALIDA;
+    int err = posix_fallocate(salida->fd, 0, nuevo_tam);
+    if (err != 0) { errno = err; reportar_error_y_salir("posix_fallocate (salida)"); }
+    munmap(salida->mapa, salida->tam_mapa);
+    salida->mapa = mmap(NULL, nuevo_tam, PROT_READ | PROT_WRITE, MAP_SHARED, salida->fd, 0);
+    if (salida->mapa == MAP_FAILED) reportar_error_y_salir("mmap (salida)");
+    salida->tam_mapa = nuevo_tam;
+    salida->sucio_desde = nuevo_tam;
+}
+
+// Escribe 'len' bytes en la posicion 'posicion' del archivo de salida.
+// La latencia de la unidad se registra cuando sus bytes llegan al kernel.
+void salida_escribir(struct SalidaReceptor *salida, long posicion, const unsigned char *datos, size_t len,
+                     long t_encolado_ns) {
+    if (salida->modo == SALIDA_STDIO) {
+        // El FILE puede estar compartido entre hilos: fseek + fwrite deben ir juntos
+        flockfile(salida->archivo);
+        if (fseek(salida->archivo, posicion, SEEK_SET) != 0) {
+            reportar_error_y_salir("fseek (archivo salida)");
+        }
+        if (fwrite(datos, 1, len, salida->archivo) != len) {
+            reportar_error_y_salir("fwrite (archivo salida)");
+        }
+        fflush(salida->archivo);
+        funlockfile(salida->archivo);
+        checkpoint_registrar(salida->checkpoint, posicion, len);
+        salida_anotar_marca(salida, t_encolado_ns);
+        salida_entregar_marcas(salida);
+        return;
+    }
+
+    if (salida->modo == SALIDA_PWRITE) {
+        // Si no continua el rango pendiente o no cabe, se escribe lo acumulado
+        if (salida->pendiente_len > 0 &&
+            (posicion != salida->pendiente_inicio + (long)salida->pendiente_len ||
+             salida->pendiente_len + len > salida->intervalo_flush)) {
+            salida_vaciar(salida);
+        }
+        if (len > salida->intervalo_flush) {
+            escribir_completo(salida->fd, datos, len, posicion);
+            checkpoint_registrar(salida->checkpoint, posicion, len);
+            salida_anotar_marca(salida, t_encolado_ns);
+            salida_entregar_marcas(salida);
+            return;
+        }
+        if (salida->pendiente_len == 0) salida->pendiente_inicio = posicion;
+        memcpy(salida->pendiente + salida->pendiente_len, datos, len);
+        salida->pendiente_len += len;
+        salida_anotar_marca(salida, t_encolado_ns);
+        return;
+    }
+
+    if (salida->modo == SALIDA_URING) {
+        if (len > salida->intervalo_flush) {
+            uring_drenar(salida);
+            escribir_completo(salida->fd, datos, len, posicion);
+            checkpoint_registrar(salida->checkpoint, posicion, len);
+            salida_anotar_marca(salida, t_encolado_ns);
+            salida_entregar_marcas(salida);
+            return;
+        }
+        // Mismo criterio de agrupado que SALIDA_PWRITE, pero el buffer lleno se sella
+        // y se sigue consumiendo mientras el kernel lo escribe
+        struct BufferSalida *b = salida->actual >= 0 ? &salida->buffers[salida->actual] : NULL;
+        if (b != NULL && b->len > 0 &&
+            (posicion != b->inicio + (long)b->len || b->len + len > salida->intervalo_flush)) {
+            uring_sellar(salida);
+            b = NULL;
+        }
+        if (b == NULL) b = uring_buffer_libre(salida);
+        if (b->len == 0) b->inicio = posicion;
+        memcpy(b->datos + b->len, datos, len);
+        b->len += len;
+        salida_anotar_marca(salida, t_encolado_ns);
+        return;
+    }
+
+    // SALIDA_MMAP
+    if ((size_t)posicion + len > salida->tam_mapa) salida_crecer(salida, posicion + len);
+    memcpy(salida->mapa + posicion, datos, len);
+    checkpoint_registrar(salida->checkpoint, posicion, len);
+    salida_anotar_marca(salida, t_encolado_ns);
+    if ((size_t)posicion < salida->sucio_desde) salida->sucio_desde = posicion;
+    if ((size_t)posicion + len > salida->sucio_hasta) salida->sucio_hasta = posicion + len;
+    if (salida->sucio_hasta - salida->sucio_desde >= salida->intervalo_flush) salida_vaciar(salida);
+}
+
+void salida_cerrar(struct SalidaReceptor *salida) {
+    salida_vaciar(salida);
+    if (salida->mapa != NULL) munmap(salida->mapa, salida->tam_mapa);
+    if (!salida->compartida) {
+        if (salida->archivo != NULL) fclose(salida->archivo);
+        if (salida->fd != -1) close(salida->fd);
+    }
+    free(salida->pendiente);
+    free(salida->marcas);
+    if (salida->uring != NULL) {
+        uring_destruir(salida->uring);
+        free(salida->uring);
+    }
+    for (int i = 0; salida->buffers != NULL && i < salida->num_buffers; i++) {
+        free(salida->buffers[i].datos);
+        free(salida->buffers[i].marcas);
+    }
+    free(salida->buffers);
+    free(salida->sellados);
+}
+
+// --manifiesto: salidas abiertas de los ultimos trabajos vistos. Los emisores avanzan
+// casi en orden por la tabla, asi que bastan unas pocas; se reemplazan en ronda.
+#define SALIDAS_TRABAJO 4
+
+struct SalidasTrabajo {
+    struct SalidaReceptor salidas[SALIDAS_TRABAJO];
+    int trabajo[SALIDAS_TRABAJO];   // Trabajo de cada salida (-1 = libre)
+    int siguiente;                  // Proxima a reemplazar
+    struct HistogramaLatencia *latencia;
+};
+
+void salidas_trabajo_iniciar(struct SalidasTrabajo *cache, struct HistogramaLatencia *latencia) {
+    memset(cache, 0, sizeof(*cache));
+    for (int i = 0; i < SALIDAS_TRABAJO; i++) cache->trabajo[i] = -1;
+    cache->latencia = latencia;
+}
+
+// Devuelve la salida del trabajo 'id', abriendola si no esta en la cache
+struct SalidaReceptor *salidas_trabajo_obtener(struct SalidasTrabajo *cache, struct TablaTrabajos *tabla, int id,
+                                               int modo, size_t intervalo_flush, int num_buffers) {
+    for (int i = 0; i < SALIDAS_TRABAJO; i++) {
+        if (cache->trabajo[i] == id) return &cache->salidas[i];
+    }
+    int i = cache->siguiente;
+    cache->siguiente = (i + 1) % SALIDAS_TRABAJO;
+    if (cache->trabajo[i] != -1) salida_cerrar(&cache->salidas[i]);
+    salida_abrir(&cache->salidas[i], tabla->trabajos[id].salida, modo, intervalo_flush, num_buffers);
+    cache->salidas[i].latencia = cache->latencia;
+    cache->trabajo[i] = id;
+    return &cache->salidas[i];
+}
+
+void salidas_trabajo_vaciar(struct SalidasTrabajo *cache) {
+    for (int i = 0; i < SALIDAS_TRABAJO; i++) {
+        if (cache->trabajo[i] != -1) salida_vaciar(&cache->salidas[i]);
+    }
+}
+
+void salidas_trabajo_cerrar(struct SalidasTrabajo *cache) {
+    for (int i = 0; i < SALIDAS_TRABAJO; i++) {
+        if (cache->trabajo[i] != -1) salida_cerrar(&cache->salidas[i]);
+        cache->trabajo[i] = -1;
+    }
+}
+
+// Opciones del lanzador que se pasan a cada receptor
+struct OpcionesReceptor {
+    int modo_manual;                // 1 = esperar ENTER antes de cada consumo
+    int hilos;                      // 1 = receptores como pthreads de un solo proceso
+    int modo_salida;                // SALIDA_STDIO, SALIDA_PWRITE, SALIDA_MMAP o SALIDA_URING
+    size_t intervalo_flush;         // Bytes entre vaciados del motor de salida
+    int buffers_en_vuelo;           // SALIDA_URING: buffers (y escrituras en vuelo) por receptor
+    const char *dir_bitacora;       // Modo silencioso: directorio de la bitacora binaria (NULL = imprimir tabla)
+    struct Afinidad afinidad;       // CPUs a las que se fija cada receptor (--cpus)
+};
+
+// Recursos del segmento que usa un receptor. Cada proceso hijo abre los suyos;
+// en modo hilos el lanzador los abre una sola vez y todos los hilos los comparten.
+struct RecursosReceptor {
+    struct MemoriaCompartida *memoria;
+    size_t total_size;
+    struct Sincronizacion sync;
+    struct TablaTrabajos *tabla;    // --manifiesto: tabla de trabajos (NULL si no)
+    size_t tam_tabla;
+    struct Checkpoint *checkpoint;  // --checkpoint: marca de lo escrito (NULL si no)
+    size_t tam_checkpoint;
+};
+
+void recursos_receptor_abrir(struct RecursosReceptor *recursos, const char *shm_name) {
+    int shm_fd = segmento_abrir(shm_name, O_RDWR);
     if (shm_fd == -1) reportar_error_y_salir("Error en shm_open");
 
-    struct stat shm_stat;
-    if (fstat(shm_fd, &shm_stat) == -1) reportar_error_y_salir("fstat");
-    size_t total_size = shm_stat.st_size;
+    size_t tam_archivo;
+    recursos->memoria = redimension_mapear(shm_fd, &recursos->total_size, &tam_archivo);
+    segmento_preparar(recursos->memoria, tam_archivo);
+    close(shm_fd);
+
+    sincronizacion_abrir(&recursos->sync, shm_name, recursos->memoria);
+
+    recursos->tabla = NULL;
+    if (recursos->memoria->manifiesto) recursos->tabla = trabajos_abrir(shm_name, &recursos->tam_tabla);
 
-    struct MemoriaCompartida *memoria = (struct MemoriaCompartida *)mmap(
-        NULL, total_size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0
-    );
+    recursos->checkpoint = NULL;
+    if (recursos->memoria->checkpoint) recursos->checkpoint = checkpoint_abrir(shm_name, &recursos->tam_checkpoint);
+}
+
+void recursos_receptor_cerrar(struct RecursosReceptor *recursos) {
+    if (recursos->tabla != NULL) trabajos_cerrar(recursos->tabla, recursos->tam_tabla);
+    if (recursos->checkpoint != NULL) checkpoint_cerrar(recursos->checkpoint, recursos->tam_checkpoint);
+    munmap(recursos->memoria, recursos->total_size);
+    sincronizacion_cerrar(&recursos->sync);
+}
 
-    if (memoria == MAP_FAILED) reportar_error_y_salir("mmap");
+// Bucle de un receptor (proceso o hilo): registro, consumo hasta el cierre y baja.
+// Con 'salida_base' (modo hilos) se comparte el descriptor del archivo de salida.
+void receptor_bucle(struct RecursosReceptor *recursos, const struct SalidaReceptor *salida_base,
+                    const char *archivo_salida_nombre, const struct OpcionesReceptor *opciones) {
+    struct MemoriaCompartida *memoria = recursos->memoria;
+    struct Sincronizacion sync = recursos->sync;
+    int modo_manual = opciones->modo_manual;
+    if (modo_manual) {
+        printf (ANSI_COLOR_BLUE "[WORKER (PID: %d)] Modo: Manual\n" ANSI_COLOR_RESET, id_trabajador());
+    }
 
-    // --- Abrir el archivo (cada hijo abre su propia copia) ---
-    FILE *archivo_salida = fopen(archivo_salida_nombre, "r+");
-    if (archivo_salida == NULL) {
-        fprintf(stderr, "Error (PID %d) al abrir el archivo salida: %s\n", getpid(), archivo_salida_nombre);
-        reportar_error_y_salir("fopen");
+    // --- Abrir el archivo (cada hijo abre su propia copia; los hilos comparten el del lanzador) ---
+    // Con manifiesto cada receptor (hijo o hilo) abre las salidas de los trabajos a medida que llegan
+    struct TablaTrabajos *tabla = recursos->tabla;
+    struct SalidasTrabajo *salidas_trabajo = NULL;
+    struct SalidaReceptor salida;
+    if (tabla != NULL) {
+        memset(&salida, 0, sizeof(salida));
+        salida.fd = -1;
+        salidas_trabajo = malloc(sizeof(*salidas_trabajo));
+        if (salidas_trabajo == NULL) reportar_error_y_salir("malloc (salidas)");
+    } else if (salida_base != NULL) {
+        salida_abrir_compartida(&salida, salida_base);
+    } else {
+        salida_abrir(&salida, archivo_salida_nombre, opciones->modo_salida, opciones->intervalo_flush,
+                     opciones->buffers_en_vuelo);
     }
 
-    unsigned char clave_decodificar = memoria->llave_desencriptar;
+    // Unidad que llega por el buffer: un caracter o una corrida de hasta tam_bloque bytes
+    struct Bloque item;
+    item.datos = malloc(memoria->tam_bloque);
+    if (item.datos == NULL) reportar_error_y_salir("malloc (bloque)");
 
-    if (sem_wait(sem_mutex) == -1) reportar_error_y_salir("sem_wait (mutex register)");
+    // En modo silencioso cada consumo se anota en la bitacora en vez de imprimirse
+    struct Bitacora *bitacora = NULL;
+    if (opciones->dir_bitacora != NULL) {
+        bitacora = malloc(sizeof(*bitacora));
+        if (bitacora == NULL) reportar_error_y_salir("malloc (bitacora)");
+        bitacora_abrir(bitacora, opciones->dir_bitacora, EVENTO_RECEPTOR);
+    }
+
+    if (semaforo_esperar(&sync.mutex) == -1) reportar_error_y_salir("sem_wait (mutex register)");
     memoria->receptores_activos++;
-    if (sem_post(sem_mutex) == -1) reportar_error_y_salir("sem_post (mutex register)");
+    if (semaforo_senalar(&sync.mutex) == -1) reportar_error_y_salir("sem_post (mutex register)");
+
+    struct MetricasTrabajador *metricas = metricas_registrar(memoria, TRABAJADOR_RECEPTOR);
+    struct LatenciaReceptor *latencia = latencia_registrar_receptor(memoria);
+    salida.latencia = &latencia->escritura;
+    salida.checkpoint = recursos->checkpoint;
+    if (salidas_trabajo != NULL) salidas_trabajo_iniciar(salidas_trabajo, &latencia->escritura);
+
+    // Con anillos fragmentados el receptor tiene un anillo de casa (se reparten en orden
+    // de llegada) y roba de los demas cuando esta vacio; no usa sem_full ni sem_empty
+    int fragmentado = memoria->protocolo_anillo == ANILLO_FRAGMENTADO;
+    int casa = 0;
+    int origen = -1;    // Anillo del que salio el item actual
+    struct Semaforo llenos_casa;
+    if (fragmentado) {
+        casa = atomic_fetch_add(&memoria->consumidores.casas_asignadas, 1) % memoria->num_fragmentos;
+        llenos_casa = fragmento_semaforo(memoria, &fragmento(memoria, casa)->llenos);
+    }
+    struct Semaforo *ocupacion = fragmentado ? &llenos_casa : &sync.full;
+
+    // En orden de fuente cada unidad va a su offset de la fuente: sin contador compartido
+    // de salida, y el resultado no depende de cuantos emisores y receptores haya
+    int orden_fuente = memoria->orden_salida == ORDEN_FUENTE;
+    long fin_escrito = 0;   // Mayor fin escrito por este receptor (para recortar al final)
 
     // --- Loop Principal del receptor ---
     for (;;) {
         // --- BLOQUE ---
-        if (sem_wait(sem_full) == -1) {
-            if (errno == EINTR) continue;
-            reportar_error_y_salir("sem_wait (full)");
+        long t_espera = metricas_bloqueo_inicio(metricas);
+        if (fragmentado) {
+            origen = fragmentos_tomar(memoria, casa, &item);
+            metricas_bloqueo_fin(metricas, t_espera);
+            if (origen < 0) break;
+        } else {
+            if (semaforo_esperar(&sync.full) == -1) {
+                if (errno == EINTR) continue;
+                reportar_error_y_salir("sem_wait (full)");
+            }
+            // Con --sync robusto, si muere desde aqui la purga devuelve el espacio tomado
+            sincronizacion_credito(memoria, metricas, SYNC_FULL);
+            metricas_bloqueo_fin(metricas, t_espera);
         }
         
         if (modo_manual) {
-            printf(ANSI_COLOR_YELLOW "[RECEPTOR HIJO (PID: %d)] Presione ENTER para consumir item...\n" ANSI_COLOR_RESET, getpid());
+            printf(ANSI_COLOR_YELLOW "[RECEPTOR HIJO (PID: %d)] Presione ENTER para consumir item...\n" ANSI_COLOR_RESET, id_trabajador());
             getchar();
         }
         
-        struct CharInfo item;
-        int mi_indice_archivo_salida;
+        long mi_indice_archivo_salida;
 
+        if (fragmentado) {
+            // El item ya salio de su anillo en fragmentos_tomar
+            mi_indice_archivo_salida = orden_fuente ? item.offset_fuente :
+                atomic_fetch_add_explicit(&memoria->consumidores.idx_archivo_escritura, item.longitud, memory_order_relaxed);
+            atomic_fetch_add_explicit(&memoria->consumidores.total_consumidos, item.longitud, memory_order_relaxed);
+        } else if (memoria->protocolo_anillo == ANILLO_LOCKFREE) {
+            if (memoria->shutdown_flag) {
+                semaforo_senalar(&sync.full);
+                break;
+            }
 
-        // --- INICIO SECCION CRITICA (LECTURA DE BUFFER) ---
-        if (sem_wait(sem_mutex) == -1) {
-            if (errno == EINTR) continue;
-            reportar_error_y_salir("sem_wait (mutex)");
-        }
+            // --- DESENCOLADO SIN LOCKS ---
+            // Solo falla si el emisor aun esta publicando la celda: se reintenta
+            while (!anillo_desencolar(memoria, &item)) sched_yield();
+            mi_indice_archivo_salida = orden_fuente ? item.offset_fuente :
+                atomic_fetch_add_explicit(&memoria->consumidores.idx_archivo_escritura, item.longitud, memory_order_relaxed);
+            atomic_fetch_add_explicit(&memoria->consumidores.total_consumidos, item.longitud, memory_order_relaxed);
+        } else {
+            // --- INICIO SECCION CRITICA (LECTURA DE BUFFER) ---
+            // Ya se tomo un espacio lleno: un EINTR no debe perderlo
+            t_espera = metricas_ahora_ns();
+            while (semaforo_esperar(&sync.cons) == -1) {
+                if (errno != EINTR) reportar_error_y_salir("sem_wait (cons)");
+            }
+            long t_lock = metricas_ahora_ns();
+            metricas_sumar(&metricas->ns_espera_mutex, t_lock - t_espera);
 
-        if (memoria->shutdown_flag) {
-            sem_post(sem_mutex);
-            sem_post(sem_full);
-            break;
-        }
+            if (memoria->shutdown_flag) {
+                semaforo_senalar(&sync.cons);
+                sincronizacion_credito(memoria, metricas, 0);
+                semaforo_senalar(&sync.full);
+                break;
+            }
 
-        int indice_lectura_buffer = memoria->idx_lectura;
-        item = memoria->buffer[indice_lectura_buffer];
-        memoria->idx_lectura = (indice_lectura_buffer + 1) % memoria->buffer_size;
+            int indice_lectura_buffer = memoria->consumidores.idx_lectura;
+            sincronizacion_deshacer_guardar(memoria, SYNC_CONS, metricas);
+            registro_leer(memoria, indice_lectura_buffer, &item);
+            memoria->consumidores.idx_lectura = (indice_lectura_buffer + 1) % memoria->buffer_size;
+            atomic_store_explicit(&memoria->consumidores.celdas_leidas,
+                                  atomic_load_explicit(&memoria->consumidores.celdas_leidas, memory_order_relaxed) + 1,
+                                  memory_order_relaxed);
 
-        mi_indice_archivo_salida = memoria->idx_archivo_escritura;
-        memoria->idx_archivo_escritura++;
-        
-        memoria->total_consumidos++;
+            if (orden_fuente) {
+                mi_indice_archivo_salida = item.offset_fuente;
+            } else {
+                mi_indice_archivo_salida = memoria->consumidores.idx_archivo_escritura;
+                memoria->consumidores.idx_archivo_escritura += item.longitud;
+            }
+
+            memoria->consumidores.total_consumidos += item.longitud;
+            sincronizacion_deshacer_confirmar(memoria, SYNC_CONS, metricas);
 
-        if (sem_post(sem_mutex) == -1) reportar_error_y_salir("sem_post (mutex)");
-        // --- FIN SECCION CRITICA (LECTURA DE BUFFER) ---
+            if (semaforo_senalar(&sync.cons) == -1) reportar_error_y_salir("sem_post (cons)");
+            metricas_sumar(&metricas->ns_retencion_mutex, metricas_ahora_ns() - t_lock);
+            // --- FIN SECCION CRITICA (LECTURA DE BUFFER) ---
+        }
 
-        // Senalizar espacio vacio
-        if (sem_post(sem_empty) == -1) reportar_error_y_salir("sem_post (empty)");
+        latencia_registrar(&latencia->desencolado, metricas_ahora_ns() - item.t_encolado_ns);
+
+        // Senalizar espacio vacio (al emisor dueno del anillo, si es fragmentado)
+        if (fragmentado) {
+            if (fragmento_liberar(memoria, origen) == -1) reportar_error_y_salir("futex (libres)");
+        } else {
+            sincronizacion_credito(memoria, metricas, 0);
+            if (semaforo_senalar(&sync.empty) == -1) reportar_error_y_salir("sem_post (empty)");
+        }
+        metricas_unidad(metricas, item.longitud, ocupacion);
 
         // Decodificar el Item (fuera de la seccion critica)
-        char cahr_decodificado = item.valor_ascii ^ clave_decodificar;
-        if (fseek(archivo_salida, mi_indice_archivo_salida, SEEK_SET) != 0) {
-            reportar_error_y_salir("fseek (archivo salida)");
+        unsigned char primer_cifrado = item.datos[0];
+        cifrado_aplicar(memoria, &item);
+        unsigned char clave_decodificar = primer_cifrado ^ item.datos[0];
+        if (tabla != NULL) {
+            // La posicion es la del archivo de su trabajo, no la de la corrida
+            struct SalidaReceptor *destino = salidas_trabajo_obtener(salidas_trabajo, tabla, item.trabajo,
+                                                                     opciones->modo_salida, opciones->intervalo_flush,
+                                                                     opciones->buffers_en_vuelo);
+            long posicion = orden_fuente ? item.offset_fuente : trabajos_posicion_salida(tabla, item.trabajo, item.longitud);
+            salida_escribir(destino, posicion, item.datos, item.longitud, item.t_encolado_ns);
+            trabajos_consumir(tabla, item.trabajo, item.longitud);
+        } else {
+            salida_escribir(&salida, mi_indice_archivo_salida, item.datos, item.longitud, item.t_encolado_ns);
+            if (mi_indice_archivo_salida + item.longitud > fin_escrito) fin_escrito = mi_indice_archivo_salida + item.longitud;
         }
-        if (fputc(cahr_decodificado, archivo_salida) == EOF) {
-            reportar_error_y_salir("fputc (archivo salida)");
+        if (bitacora != NULL) {
+            bitacora_registrar(bitacora, item.offset_fuente, item.indice, item.longitud,
+                               item.datos[0] ^ clave_decodificar, item.datos[0]);
+        } else {
+            imprimir_produccion(memoria, &item, clave_decodificar);
         }
-        fflush(archivo_salida);
-        imprimir_produccion(&item, cahr_decodificado);
     }
 
     // --- Limpieza del proceso hijo ---
+    metricas_terminar(metricas);
     printf(ANSI_COLOR_BLUE  "--------------------------------------------------------------------------------------" ANSI_COLOR_RESET "\n");
 
-    if (sem_wait(sem_mutex) == -1) reportar_error_y_salir("sem_wait (mutex unregister)");
+    // Vaciar lo pendiente antes de dejar de contar como receptor activo
+    salida_vaciar(&salida);
+    if (salidas_trabajo != NULL) salidas_trabajo_vaciar(salidas_trabajo);
+
+    if (semaforo_esperar(&sync.mutex) == -1) reportar_error_y_salir("sem_wait (mutex unregister)");
     memoria->receptores_activos--;
     int emisores_vivos = memoria->emisores_activos;
     int receptores_vivos = memoria->receptores_activos;
-    if (sem_post(sem_mutex) == -1 ) reportar_error_y_salir("sem_post (mutex unregister)");
+    if (fin_escrito > memoria->consumidores.fin_salida) memoria->consumidores.fin_salida = fin_escrito;
+    long bytes_escritos = orden_fuente ? memoria->consumidores.fin_salida : memoria->consumidores.idx_archivo_escritura;
+    if (semaforo_senalar(&sync.mutex) == -1 ) reportar_error_y_salir("sem_post (mutex unregister)");
+
+    // El ultimo receptor recorta el archivo pre-dimensionado a lo realmente escrito
+    // (con manifiesto, las salidas de los trabajos que no llegaron a completarse)
+    if (receptores_vivos == 0 && tabla != NULL) {
+        for (int i = 0; i < tabla->num_trabajos; i++) {
+            struct Trabajo *t = &tabla->trabajos[i];
+            if (atomic_load(&t->estado) != TRABAJO_COMPLETO) truncate(t->salida, atomic_load(&t->idx_salida));
+        }
+    } else if (receptores_vivos == 0 && opciones->modo_salida != SALIDA_STDIO) {
+        if (ftruncate(salida.fd, bytes_escritos) == -1) reportar_error_y_salir("ftruncate (salida)");
+    }
+    // Todos los receptores ya vaciaron: la marca no va a moverse mas en esta corrida
+    if (receptores_vivos == 0 && recursos->checkpoint != NULL) checkpoint_guardar(recursos->checkpoint);
 
     if (emisores_vivos == 0 && receptores_vivos == 0) {
-        printf(ANSI_COLOR_YELLOW "PID: %d ¡SOY EL ÚLTIMO! Avisando al finalizador.\n" ANSI_COLOR_RESET, getpid());
-        if (sem_post(sem_fin) == -1) reportar_error_y_salir("sem_post (fin)");
+        printf(ANSI_COLOR_YELLOW "PID: %d ¡SOY EL ÚLTIMO! Avisando al finalizador.\n" ANSI_COLOR_RESET, id_trabajador());
+        if (semaforo_senalar(&sync.fin) == -1) reportar_error_y_salir("sem_post (fin)");
     }
 
-    fclose(archivo_salida);
-    munmap(memoria, total_size);
-    close(shm_fd);
-    sem_close(sem_mutex);
-    sem_close(sem_empty);
-    sem_close(sem_full);
-    sem_close(sem_fin);
+    if (bitacora != NULL) {
+        bitacora_cerrar(bitacora);
+        free(bitacora);
+    }
+    free(item.datos);
+    salida_cerrar(&salida);
+    if (salidas_trabajo != NULL) {
+        salidas_trabajo_cerrar(salidas_trabajo);
+        free(salidas_trabajo);
+    }
+}
+
+void receptor_worker(const char* shm_name, const char* archivo_salida_nombre, const struct OpcionesReceptor *opciones) {
+    // --- Conectar a los Recursos IPC ---
+    struct RecursosReceptor recursos;
+    recursos_receptor_abrir(&recursos, shm_name);
+
+    receptor_bucle(&recursos, NULL, archivo_salida_nombre, opciones);
+
+    recursos_receptor_cerrar(&recursos);
     exit(EXIT_SUCCESS);
 }
 
+// Argumento de cada hilo receptor en el modo --hilos
+struct HiloReceptor {
+    pthread_t hilo;
+    struct RecursosReceptor *recursos;
+    const struct SalidaReceptor *salida_base;
+    const struct OpcionesReceptor *opciones;
+    int indice;                     // Numero de receptor (para la afinidad)
+};
+
+void *receptor_hilo(void *arg) {
+    struct HiloReceptor *h = (struct HiloReceptor *)arg;
+    afinidad_aplicar(&h->opciones->afinidad, h->indice);
+    receptor_bucle(h->recursos, h->salida_base, NULL, h->opciones);
+    return NULL;
+}
+
+// Modo --hilos: los receptores corren como pthreads que comparten el mapeo, los
+// semaforos y el descriptor de salida; sem_cons pasa a ser privado del proceso, salvo
+// con buffer redimensionable: el emisor que redimensiona tambien debe poder tomarlo.
+void lanzar_hilos(struct RecursosReceptor *recursos, int num_receptores, const char *archivo_salida_nombre,
+                  const struct OpcionesReceptor *opciones) {
+    sem_t cons_privado;
+    struct Semaforo cons_original;
+    int privatizar = !recursos->memoria->redimension;
+    if (privatizar) semaforo_privatizar(&recursos->sync.cons, &cons_privado, 1, &cons_original);
+
+    // Con manifiesto no hay un archivo unico que compartir: cada hilo abre los de sus trabajos
+    int manifiesto = recursos->tabla != NULL;
+    struct SalidaReceptor salida_base;
+    if (!manifiesto) {
+        salida_abrir_archivo(&salida_base, archivo_salida_nombre, opciones->modo_salida, opciones->intervalo_flush,
+                             opciones->buffers_en_vuelo);
+    }
+
+    struct HiloReceptor *hilos = calloc(num_receptores, sizeof(struct HiloReceptor));
+    if (hilos == NULL) reportar_error_y_salir("calloc (hilos)");
+
+    for (int i = 0; i < num_receptores; i++) {
+        hilos[i].recursos = recursos;
+        hilos[i].salida_base = manifiesto ? NULL : &salida_base;
+        hilos[i].opciones = opciones;
+        hilos[i].indice = i;
+        int err = pthread_create(&hilos[i].hilo, NULL, receptor_hilo, &hilos[i]);
+        if (err != 0) { errno = err; reportar_error_y_salir("pthread_create"); }
+    }
+
+    for (int i = 0; i < num_receptores; i++) {
+        pthread_join(hilos[i].hilo, NULL);
+        printf(ANSI_COLOR_GREEN "[PADRE (PID: %d)] Hilo %d ha terminado. \n" ANSI_COLOR_RESET, getpid(), i);
+    }
+
+    free(hilos);
+    if (!manifiesto) salida_cerrar(&salida_base);
+    if (privatizar) semaforo_restaurar(&recursos->sync.cons, &cons_privado, &cons_original);
+
+    // Los hilos ya no usan el sem_cons privado: otros lanzadores vuelven a ser validos
+    if (semaforo_esperar(&recursos->sync.mutex) == -1) reportar_error_y_salir("Padre: sem_wait (mutex hilos)");
+    recursos->memoria->receptores_hilos = 0;
+    if (semaforo_senalar(&recursos->sync.mutex) == -1) reportar_error_y_salir("Padre: sem_post (mutex hilos)");
+}
+
 int main(int argc, char *argv[]) {
     // --- Validar argumentos ---
-    if (argc != 4) {
-        fprintf(stderr, "Uso: %s <shm_id> <modo (manual|automatico)> <num_receptores>\n", argv[0]);
+    if (argc < 4) {
+        fprintf(stderr, "Uso: %s <shm_id> <modo (manual|automatico)> <num_receptores> "
+                        "[--hilos] [--salida stdio|pwrite|mmap|uring] [--flush <bytes>] [--en-vuelo <n>] [--bitacora <dir>]\n"
+                        "          [--cpus compacta|dispersa|nodo:<N>|<lista>] [--cpu-desde <k>]\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
@@ -194,20 +935,74 @@ int main(int argc, char *argv[]) {
     const char* modo_ejecucion = argv[2];
     int num_receptores = atoi(argv[3]);
 
-    const char* dir_salida = "files";
-    const char* archivo_salida_nombre = "files/output.txt";
-
-    if (mkdir(dir_salida, 0777) == -1) {
-        if(errno != EEXIST) {
-            reportar_error_y_salir("mkdir");
+    // --- Opciones del motor de salida ---
+    struct OpcionesReceptor opciones;
+    opciones.modo_manual = 0;
+    opciones.hilos = 0;
+    opciones.modo_salida = SALIDA_STDIO;     // Comportamiento original; los demas motores se eligen con --salida
+    opciones.buffers_en_vuelo = EN_VUELO_DEFECTO;
+    opciones.dir_bitacora = NULL;
+    opciones.afinidad.politica = AFINIDAD_NINGUNA;
+    opciones.afinidad.desde = 0;
+    long intervalo_flush = FLUSH_SALIDA_DEFECTO;
+    for (int i = 4; i < argc; i++) {
+        if (strcmp(argv[i], "--hilos") == 0 || strcmp(argv[i], "--threads") == 0) {
+            opciones.hilos = 1;
+        } else if (strcmp(argv[i], "--salida") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "stdio") == 0) opciones.modo_salida = SALIDA_STDIO;
+            else if (strcmp(argv[i], "pwrite") == 0) opciones.modo_salida = SALIDA_PWRITE;
+            else if (strcmp(argv[i], "mmap") == 0) opciones.modo_salida = SALIDA_MMAP;
+            else if (strcmp(argv[i], "uring") == 0) opciones.modo_salida = SALIDA_URING;
+            else {
+                fprintf(stderr, "Error: --salida debe ser 'stdio', 'pwrite', 'mmap' o 'uring'.\n");
+                exit(EXIT_FAILURE);
+            }
+        } else if (strcmp(argv[i], "--flush") == 0 && i + 1 < argc) {
+            intervalo_flush = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--en-vuelo") == 0 && i + 1 < argc) {
+            opciones.buffers_en_vuelo = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bitacora") == 0 && i + 1 < argc) {
+            opciones.dir_bitacora = argv[++i];
+        } else if (strcmp(argv[i], "--cpus") == 0 && i + 1 < argc) {
+            if (afinidad_parsear(&opciones.afinidad, argv[++i]) == -1) {
+                fprintf(stderr, "Error: politica de CPUs invalida '%s'.\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+        } else if (strcmp(argv[i], "--cpu-desde") == 0 && i + 1 < argc) {
+            opciones.afinidad.desde = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Error: opcion desconocida '%s'.\n", argv[i]);
+            exit(EXIT_FAILURE);
         }
     }
 
-    FILE *fp = fopen(archivo_salida_nombre, "w");
-    if (fp == NULL) {
-        reportar_error_y_salir("fopen (truncar en main)");
+    if (intervalo_flush <= 0) {
+        fprintf(stderr, "Error: El intervalo de flush debe ser mayor que 0.\n");
+        exit(EXIT_FAILURE);
+    }
+    opciones.intervalo_flush = intervalo_flush;
+
+    if (opciones.buffers_en_vuelo <= 0) {
+        fprintf(stderr, "Error: --en-vuelo debe ser mayor que 0.\n");
+        exit(EXIT_FAILURE);
     }
-    fclose(fp);
+
+    if (opciones.afinidad.desde < 0) {
+        fprintf(stderr, "Error: --cpu-desde no puede ser negativo.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Validar modo
+    if (strcmp(modo_ejecucion, "manual") == 0) {
+        opciones.modo_manual = 1;
+    } else if (strcmp(modo_ejecucion, "automatico") != 0) {
+        fprintf(stderr, "Error: Modo debe ser 'manual' o 'automatico'.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    const char* dir_salida = "files";
+    const char* archivo_salida_nombre = "files/output.txt";
 
     if (num_receptores <= 0) {
         fprintf(stderr, "Error: El numero de receptores debe ser 1 o mas.\n");
@@ -215,41 +1010,117 @@ int main(int argc, char *argv[]) {
     }
 
     printf(ANSI_COLOR_GREEN "--- Lanzador de Receptores (PID: %d) ---" ANSI_COLOR_RESET, getpid());
-    printf("Lanzando %d procesos receptores (heavy process)...\n", num_receptores);
+    if (opciones.hilos) {
+        printf("Lanzando %d hilos receptores en un solo proceso...\n", num_receptores);
+    } else {
+        printf("Lanzando %d procesos receptores (heavy process)...\n", num_receptores);
+    }
 
-    // --- Imprimir encabezado de la tabla ---
-    printf("\n" ANSI_COLOR_BLUE "--------------------------------------------------------------------------------------" ANSI_COLOR_RESET "\n");
-    printf(ANSI_COLOR_BLUE "%-20s | %-12s | %-20s | %-8s | %-10s |\n" ANSI_COLOR_RESET,
-           "PROCESO", "ORIGINAL", "CIFRADO (HEX)", "ÍNDICE", "HORA");
-    printf(ANSI_COLOR_BLUE "--------------------------------------------------------------------------------------" ANSI_COLOR_RESET "\n");
+    // Se eligen los kernels de cifrado antes del fork para que los hijos hereden la eleccion
+    cifrado_preparar();
+    printf("Kernels de cifrado: XOR %s, ChaCha20 %s\n", xor_nombre, chacha_nombre);
+
+    // Cada receptor crea su propio anillo; aqui solo se informa si el kernel lo permite
+    if (opciones.modo_salida == SALIDA_URING) {
+        struct Uring prueba;
+        if (uring_crear(&prueba, opciones.buffers_en_vuelo) == 0) {
+            printf("Salida: io_uring, %d escrituras en vuelo por receptor\n", opciones.buffers_en_vuelo);
+            uring_destruir(&prueba);
+        } else {
+            printf("Salida: io_uring no disponible (%s), respaldo con pwritev\n", strerror(errno));
+        }
+    }
+
+    // El orden de CPUs se calcula una vez en el padre; cada hijo o hilo toma la suya
+    afinidad_preparar(&opciones.afinidad);
+    afinidad_imprimir(&opciones.afinidad);
+
+    // --- Imprimir encabezado de la tabla (en modo silencioso la imprime logdump) ---
+    if (opciones.dir_bitacora == NULL) {
+        printf("\n" ANSI_COLOR_BLUE "--------------------------------------------------------------------------------------" ANSI_COLOR_RESET "\n");
+        printf(ANSI_COLOR_BLUE "%-20s | %-12s | %-20s | %-8s | %-10s |\n" ANSI_COLOR_RESET,
+               "PROCESO", "ORIGINAL", "CIFRADO (HEX)", "ÍNDICE", "HORA");
+        printf(ANSI_COLOR_BLUE "--------------------------------------------------------------------------------------" ANSI_COLOR_RESET "\n");
+    } else {
+        printf("Modo silencioso: bitacora en %s\n", opciones.dir_bitacora);
+    }
 
     // --- Conectar a SHM y Mutex (SÓLO EL PADRE) ---
-    char sem_mutex_name[512];
-    snprintf(sem_mutex_name, sizeof(sem_mutex_name), "%s%s", shm_name, SEM_MUTEX_NAME_SUFFIX);
-    sem_t *sem_mutex = sem_open(sem_mutex_name, 0);
-    // ... (Error handling) ...
-    
-    int shm_fd = shm_open(shm_name, O_RDWR, 0666);
-    if (shm_fd == -1) reportar_error_y_salir("Padre: shm_open");
-
-    struct stat shm_stat;
-    if (fstat(shm_fd, &shm_stat) == -1) reportar_error_y_salir("fstat");
-    size_t total_size = shm_stat.st_size;
-    
-    struct MemoriaCompartida *memoria = (struct MemoriaCompartida *)mmap(
-        NULL, total_size, PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0
-    );
-    if (memoria == MAP_FAILED) reportar_error_y_salir("Padre: mmap");
-    close(shm_fd);
-    
+    struct RecursosReceptor recursos;
+    recursos_receptor_abrir(&recursos, shm_name);
+    struct MemoriaCompartida *memoria = recursos.memoria;
+
     // --- Registrar el total de receptores ---
-    if (sem_wait(sem_mutex) == -1) reportar_error_y_salir("Padre: sem_wait (mutex)");
-    memoria->receptores_totales += num_receptores;
-    if (sem_post(sem_mutex) == -1) reportar_error_y_salir("Padre: sem_post (mutex)");
-    
-    munmap(memoria, total_size);
-    sem_close(sem_mutex);
-    
+    if (semaforo_esperar(&recursos.sync.mutex) == -1) reportar_error_y_salir("Padre: sem_wait (mutex)");
+    // sem_cons solo puede ser privado si no hay receptores de otros lanzadores, y mientras
+    // lo sea ningun otro lanzador puede sumarse (usaria el sem_cons compartido)
+    int otros_receptores = memoria->receptores_totales;
+    int hilos_ajenos = memoria->receptores_hilos;
+    if (!(opciones.hilos && otros_receptores != 0) && !hilos_ajenos) {
+        memoria->receptores_totales += num_receptores;
+        if (opciones.hilos) memoria->receptores_hilos = 1;
+    }
+    if (semaforo_senalar(&recursos.sync.mutex) == -1) reportar_error_y_salir("Padre: sem_post (mutex)");
+    if (hilos_ajenos) {
+        fprintf(stderr, "Error: ya hay un lanzador de receptores con --hilos; debe ser el unico de su tipo.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (opciones.hilos && otros_receptores != 0) {
+        fprintf(stderr, "Error: --hilos requiere que este sea el unico lanzador de receptores (ya hay %d).\n", otros_receptores);
+        exit(EXIT_FAILURE);
+    }
+
+    // --- Crear la salida y pre-dimensionarla al tamano de la fuente (mas no se puede escribir) ---
+    // Con manifiesto, una salida por trabajo con el tamano de su fuente
+    if (recursos.tabla != NULL) {
+        for (int i = 0; i < recursos.tabla->num_trabajos; i++) {
+            struct Trabajo *t = &recursos.tabla->trabajos[i];
+            FILE *fp = fopen(t->salida, "w");
+            if (fp == NULL) {
+                fprintf(stderr, "Error al crear la salida del trabajo %d: %s\n", i, t->salida);
+                reportar_error_y_salir("fopen (truncar en main)");
+            }
+            fclose(fp);
+            if (opciones.modo_salida != SALIDA_STDIO && t->tam > 0) {
+                if (truncate(t->salida, t->tam) == -1) reportar_error_y_salir("truncate (salida)");
+            }
+        }
+    } else {
+        if (mkdir(dir_salida, 0777) == -1) {
+            if(errno != EEXIST) {
+                reportar_error_y_salir("mkdir");
+            }
+        }
+
+        // Al reanudar se conserva lo ya escrito (el inicializador la recorto a la marca)
+        FILE *fp = fopen(archivo_salida_nombre, memoria->inicio_fuente > 0 ? "r+" : "w");
+        if (fp == NULL) {
+            reportar_error_y_salir("fopen (truncar en main)");
+        }
+        fclose(fp);
+        if (recursos.checkpoint != NULL) {
+            snprintf(recursos.checkpoint->salida, sizeof(recursos.checkpoint->salida), "%s", archivo_salida_nombre);
+        }
+
+        struct stat fuente_stat;
+        if (opciones.modo_salida != SALIDA_STDIO && stat(memoria->archivo_fuente, &fuente_stat) == 0 &&
+            S_ISREG(fuente_stat.st_mode) && fuente_stat.st_size > 0) {
+            if (truncate(archivo_salida_nombre, fuente_stat.st_size) == -1) reportar_error_y_salir("truncate (salida)");
+        }
+    }
+
+    // Vaciar stdout antes del fork para que los hijos no repitan lo ya impreso
+    fflush(stdout);
+
+    if (opciones.hilos) {
+        lanzar_hilos(&recursos, num_receptores, archivo_salida_nombre, &opciones);
+        recursos_receptor_cerrar(&recursos);
+        printf(ANSI_COLOR_GREEN "--- Receptor (PID: %d): todos los receptores han terminado --- \n" ANSI_COLOR_RESET, getpid());
+        return EXIT_SUCCESS;
+    }
+
+    recursos_receptor_cerrar(&recursos);
+
     for (int i = 0; i < num_receptores; i++) {
         pid_t pid = fork();
 
@@ -260,7 +1131,8 @@ int main(int argc, char *argv[]) {
             // Heavy process
 
             // Paso de argumentos que el padre parseo
-            receptor_worker(shm_name, modo_ejecucion, archivo_salida_nombre);
+            afinidad_aplicar(&opciones.afinidad, i);
+            receptor_worker(shm_name, archivo_salida_nombre, &opciones);
 
             // El hijo termina aqui para no continuar en el bucle 'for' del padre
             exit(EXIT_SUCCESS);
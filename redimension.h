@@ -0,0 +1,170 @@
+#ifndef REDIMENSION_H
+#define REDIMENSION_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>         // Para ftruncate
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "memInfo.h"
+#include "registro.h"
+#include "sincronizacion.h"
+#include "metricas.h"
+#include "segmento.h"
+
+// Buffer redimensionable en linea (solo ANILLO_SEMAFOROS). Todo acceso a las
+// celdas ocurre con sem_prod (emisores) o sem_cons (receptores) tomado, asi que
+// un emisor que tiene ambos puede cambiar la geometria del anillo sin que nadie
+// lo vea a medias: mueve las celdas ocupadas, ajusta sem_empty, cambia el
+// tamano del segmento con ftruncate y avanza memoria->generacion.
+//
+// Cada trabajador mapea de entrada tam_mapeo bytes (el segmento con buffer_max
+// espacios). Mapear mas alla del fin del archivo es valido mientras no se toque,
+// y crecer con ftruncate vuelve accesibles esas paginas: el puntero al segmento
+// no cambia y los hilos de un mismo lanzador no necesitan coordinarse.
+//
+// Politica, evaluada por el emisor que tiene sem_prod cada VENTANA_REDIMENSION_NS:
+//   crecer al doble si los emisores pasaron mas de UMBRAL_CRECER de la ventana bloqueados
+//   en sem_empty (solo cuenta la espera con el buffer lleno, no el costo de sem_wait)
+//   reducir a la mitad si casi no se espero (menos de UMBRAL_REDUCIR) y la ocupacion
+//   nunca paso de N / DIVISOR_REDUCIR
+
+#define VENTANA_REDIMENSION_NS  (200L * 1000000L)  // 200 ms
+#define UMBRAL_CRECER           0.5
+#define UMBRAL_REDUCIR          0.01
+#define DIVISOR_REDUCIR         4
+
+// Bytes del segmento con 'celdas' espacios, redondeado a pagina (hugetlbfs exige paginas enteras)
+static inline size_t redimension_tam_segmento(int tam_registro, int celdas, long tam_pagina) {
+    size_t tam = sizeof(struct MemoriaCompartida) + (size_t)celdas * tam_registro;
+    return (tam + tam_pagina - 1) / tam_pagina * tam_pagina;
+}
+
+// Mapea el segmento abierto en 'fd': su tamano actual o, si el buffer es
+// redimensionable, tam_mapeo. Devuelve el mapeo, su tamano en *tam y el tamano
+// actual del archivo (lo unico que se puede tocar) en *tam_archivo.
+static inline struct MemoriaCompartida *redimension_mapear(int fd, size_t *tam, size_t *tam_archivo) {
+    struct stat info;
+    if (fstat(fd, &info) == -1) reportar_error_y_salir("fstat");
+    *tam = info.st_size;
+    *tam_archivo = info.st_size;
+
+    struct MemoriaCompartida *memoria = mmap(NULL, *tam, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memoria == MAP_FAILED) reportar_error_y_salir("mmap");
+    if (!memoria->redimension || memoria->tam_mapeo <= *tam) return memoria;
+
+    size_t tam_mapeo = memoria->tam_mapeo;
+    munmap(memoria, *tam);
+    memoria = mmap(NULL, tam_mapeo, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memoria == MAP_FAILED) reportar_error_y_salir("mmap (tam_mapeo)");
+    *tam = tam_mapeo;
+    return memoria;
+}
+
+// Celdas llenas. Exacto con sem_prod y sem_cons tomados; con solo sem_prod es una estimacion.
+static inline long redimension_ocupadas(struct MemoriaCompartida *memoria) {
+    return atomic_load_explicit(&memoria->productores.celdas_escritas, memory_order_relaxed) -
+           atomic_load_explicit(&memoria->consumidores.celdas_leidas, memory_order_relaxed);
+}
+
+// Cambia el buffer a 'nuevo' espacios. Se llama con sem_prod tomado; toma sem_cons.
+// Devuelve 0 si cambio y -1 si no se pudo (el anillo queda como estaba).
+static inline int redimension_aplicar(struct MemoriaCompartida *memoria, struct Sincronizacion *sync,
+                                      int shm_fd, int nuevo) {
+    while (semaforo_esperar(&sync->cons) == -1) {
+        if (errno != EINTR) reportar_error_y_salir("sem_wait (cons redimension)");
+    }
+
+    int n = memoria->buffer_size;
+    size_t tam_registro = memoria->tam_registro;
+    long ocupadas = redimension_ocupadas(memoria);
+    int lectura = memoria->consumidores.idx_lectura;
+    int escritura = memoria->productores.idx_escritura;
+    int resultado = -1;
+
+    if (nuevo > n) {
+        size_t tam_viejo = redimension_tam_segmento(tam_registro, n, memoria->tam_pagina);
+        size_t tam_nuevo = redimension_tam_segmento(tam_registro, nuevo, memoria->tam_pagina);
+        if (ftruncate(shm_fd, tam_nuevo) == 0) {
+            if (memoria->prefault) {
+                segmento_prefaltear((unsigned char *)memoria + tam_viejo, tam_nuevo - tam_viejo, memoria->tam_pagina);
+            }
+            // Si la corrida ocupada da la vuelta, su cola [lectura, n) pasa al final del
+            // anillo nuevo para que los espacios agregados queden delante del escritor
+            if (ocupadas > 0 && lectura >= escritura) {
+                int cola = n - lectura;
+                memmove(registro_celda(memoria, nuevo - cola), registro_celda(memoria, lectura), (size_t)cola * tam_registro);
+                memoria->consumidores.idx_lectura = nuevo - cola;
+            }
+            memoria->buffer_size = nuevo;
+            for (int i = n; i < nuevo; i++) semaforo_senalar(&sync->empty);
+            memoria->veces_crecido++;
+            resultado = 0;
+        }
+    } else if (ocupadas <= nuevo) {
+        // Quitar los espacios libres sobrantes de sem_empty. Si algunos ya los tomo un
+        // emisor que espera sem_prod, no alcanzan y se desiste.
+        int quitados = 0;
+        while (quitados < n - nuevo && semaforo_intentar(&sync->empty) == 0) quitados++;
+        if (quitados < n - nuevo) {
+            while (quitados-- > 0) semaforo_senalar(&sync->empty);
+        } else {
+            // Compactar la corrida ocupada al principio del anillo
+            if (ocupadas > 0) {
+                unsigned char *copia = malloc((size_t)ocupadas * tam_registro);
+                if (copia == NULL) reportar_error_y_salir("malloc (redimension)");
+                for (long i = 0; i < ocupadas; i++) {
+                    memcpy(copia + i * tam_registro, registro_celda(memoria, (int)((lectura + i) % n)), tam_registro);
+                }
+                memcpy(registro_celda(memoria, 0), copia, (size_t)ocupadas * tam_registro);
+                free(copia);
+            }
+            memoria->consumidores.idx_lectura = 0;
+            memoria->productores.idx_escritura = (int)(ocupadas % nuevo);
+            memoria->buffer_size = nuevo;
+            // Devolver la memoria sobrante (si falla, solo queda sin liberar)
+            ftruncate(shm_fd, redimension_tam_segmento(tam_registro, nuevo, memoria->tam_pagina));
+            memoria->veces_reducido++;
+            resultado = 0;
+        }
+    }
+
+    if (resultado == 0) atomic_fetch_add(&memoria->generacion, 1);
+    if (semaforo_senalar(&sync->cons) == -1) reportar_error_y_salir("sem_post (cons redimension)");
+    return resultado;
+}
+
+// Contabiliza la espera en sem_empty de la unidad recien escrita y, al cerrar cada
+// ventana, decide si crecer o reducir. Se llama con sem_prod tomado.
+static inline void redimension_evaluar(struct MemoriaCompartida *memoria, struct Sincronizacion *sync,
+                                       int shm_fd, long ns_espera) {
+    struct EstadoRedimension *estado = &memoria->productores.redimension;
+    long ahora = metricas_ahora_ns();
+    estado->ns_esperando += ns_espera;
+    long ocupadas = redimension_ocupadas(memoria);
+    if (ocupadas > estado->ocupacion_maxima) estado->ocupacion_maxima = ocupadas;
+
+    // La primera ventana empieza con la primera unidad, no con el inicializador
+    if (estado->ventana_desde == 0) estado->ventana_desde = ahora;
+    long ventana = ahora - estado->ventana_desde;
+    if (ventana < VENTANA_REDIMENSION_NS) return;
+
+    int emisores = memoria->emisores_activos > 0 ? memoria->emisores_activos : 1;
+    double fraccion_esperando = (double)estado->ns_esperando / ((double)ventana * emisores);
+    int n = memoria->buffer_size;
+    int nuevo = n;
+    if (fraccion_esperando > UMBRAL_CRECER && n < memoria->buffer_max) {
+        nuevo = (n > memoria->buffer_max / 2) ? memoria->buffer_max : n * 2;
+    } else if (fraccion_esperando < UMBRAL_REDUCIR && estado->ocupacion_maxima < n / DIVISOR_REDUCIR && n > memoria->buffer_min) {
+        nuevo = (n / 2 < memoria->buffer_min) ? memoria->buffer_min : n / 2;
+    }
+
+    estado->ventana_desde = ahora;
+    estado->ns_esperando = 0;
+    estado->ocupacion_maxima = 0;
+    if (nuevo != n) redimension_aplicar(memoria, sync, shm_fd, nuevo);
+}
+
+#endif // REDIMENSION_H
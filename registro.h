@@ -0,0 +1,107 @@
+#ifndef REGISTRO_H
+#define REGISTRO_H
+
+#include <string.h>
+#include "memInfo.h"
+
+// Codificacion de las celdas del buffer. Los procesos trabajan siempre con un
+// struct Bloque; estas funciones lo traducen al formato configurado en el
+// segmento: un caracter por celda (completo de 16 bytes o compacto de 8) o
+// una corrida de hasta tam_bloque bytes con su offset en la fuente.
+
+// Unidad que viaja por el buffer tal como la ven emisores y receptores
+struct Bloque {
+    long offset_fuente;         // Posicion en la fuente del primer byte (-1 si el formato no la guarda)
+    int longitud;               // Bytes validos en datos (siempre 1 fuera de REGISTRO_BLOQUE)
+    int indice;                 // Celda donde fue insertado
+    int trabajo;                // Trabajo del manifiesto (solo REGISTRO_BLOQUE; 0 en los demas)
+    int64_t t_encolado_ns;      // CLOCK_MONOTONIC al encolar
+    unsigned char *datos;       // Bytes (capacidad: tam_bloque)
+};
+
+#define MARCA_COMPACTA_MAX (((int64_t)1 << 48) - 1)   // 48 bits de ns, unas 78 horas
+
+// Hora real de una marca monotona, a partir del par (tiempo_base, base_monotonica_ns)
+static inline time_t registro_hora(const struct MemoriaCompartida *memoria, int64_t t_ns) {
+    return memoria->tiempo_base + (time_t)((t_ns - memoria->base_monotonica_ns) / 1000000000LL);
+}
+
+static inline int registro_tam(int formato, int tam_bloque) {
+    if (formato == REGISTRO_BLOQUE) {
+        // Redondeado a 8 para que las celdas (y lo que venga despues) queden alineadas
+        return (int)((sizeof(struct CabeceraBloque) + tam_bloque + 7) & ~(size_t)7);
+    }
+    return (formato == REGISTRO_COMPACTO) ? (int)sizeof(struct CharInfoCompacta) : (int)sizeof(struct CharInfo);
+}
+
+static inline unsigned char *registro_celda(struct MemoriaCompartida *memoria, int celda) {
+    return memoria->buffer + (size_t)celda * memoria->tam_registro;
+}
+
+static inline void registro_escribir(struct MemoriaCompartida *memoria, int celda, const struct Bloque *item) {
+    unsigned char *destino = registro_celda(memoria, celda);
+
+    if (memoria->formato_registro == REGISTRO_BLOQUE) {
+        struct CabeceraBloque cabecera;
+        cabecera.offset_fuente = item->offset_fuente;
+        cabecera.timestamp_ns = item->t_encolado_ns;
+        cabecera.longitud = (uint32_t)item->longitud;
+        cabecera.indice = item->indice;
+        cabecera.trabajo = item->trabajo;
+        cabecera.reservado = 0;
+        memcpy(destino, &cabecera, sizeof(cabecera));
+        memcpy(destino + sizeof(cabecera), item->datos, item->longitud);
+    } else if (memoria->formato_registro == REGISTRO_COMPACTO) {
+        struct CharInfoCompacta compacta;
+        int64_t marca = item->t_encolado_ns - memoria->base_monotonica_ns;
+        if (marca < 0) marca = 0;
+        if (marca > MARCA_COMPACTA_MAX) marca = MARCA_COMPACTA_MAX;
+        compacta.marca_ns_baja = (uint32_t)marca;
+        compacta.marca_ns_alta = (uint16_t)(marca >> 32);
+        compacta.valor_ascii = (char)item->datos[0];
+        compacta.reservado = 0;
+        memcpy(destino, &compacta, sizeof(compacta));
+    } else {
+        struct CharInfo completa;
+        completa.valor_ascii = (char)item->datos[0];
+        completa.indice = item->indice;
+        completa.timestamp_ns = item->t_encolado_ns;
+        memcpy(destino, &completa, sizeof(completa));
+    }
+}
+
+static inline void registro_leer(struct MemoriaCompartida *memoria, int celda, struct Bloque *item) {
+    const unsigned char *origen = registro_celda(memoria, celda);
+
+    if (memoria->formato_registro == REGISTRO_BLOQUE) {
+        struct CabeceraBloque cabecera;
+        memcpy(&cabecera, origen, sizeof(cabecera));
+        item->offset_fuente = cabecera.offset_fuente;
+        item->t_encolado_ns = cabecera.timestamp_ns;
+        item->longitud = (int)cabecera.longitud;
+        item->indice = cabecera.indice;
+        item->trabajo = cabecera.trabajo;
+        memcpy(item->datos, origen + sizeof(cabecera), item->longitud);
+    } else if (memoria->formato_registro == REGISTRO_COMPACTO) {
+        struct CharInfoCompacta compacta;
+        memcpy(&compacta, origen, sizeof(compacta));
+        item->offset_fuente = -1;
+        item->t_encolado_ns = memoria->base_monotonica_ns +
+                              (((int64_t)compacta.marca_ns_alta << 32) | compacta.marca_ns_baja);
+        item->longitud = 1;
+        item->indice = celda;
+        item->trabajo = 0;
+        item->datos[0] = (unsigned char)compacta.valor_ascii;
+    } else {
+        struct CharInfo completa;
+        memcpy(&completa, origen, sizeof(completa));
+        item->offset_fuente = -1;
+        item->t_encolado_ns = completa.timestamp_ns;
+        item->longitud = 1;
+        item->indice = completa.indice;
+        item->trabajo = 0;
+        item->datos[0] = (unsigned char)completa.valor_ascii;
+    }
+}
+
+#endif // REGISTRO_H
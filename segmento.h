@@ -0,0 +1,109 @@
+#ifndef SEGMENTO_H
+#define SEGMENTO_H
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/vfs.h>    // Para fstatfs (tamano de pagina de hugetlbfs)
+#include "memInfo.h"
+
+// Apertura y paginas del segmento compartido. Con PAGINAS_HUGETLB el segmento no
+// vive en /dev/shm sino en un archivo de hugetlbfs con el mismo nombre; todos los
+// procesos lo buscan primero con shm_open y, si no existe, en DIR_HUGETLBFS.
+
+#ifndef DIR_HUGETLBFS
+#define DIR_HUGETLBFS "/dev/hugepages"  // Punto de montaje habitual (systemd)
+#endif
+
+static inline void segmento_ruta_hugetlbfs(const char *shm_name, char *ruta, size_t tam) {
+    snprintf(ruta, tam, "%s%s%s", DIR_HUGETLBFS, shm_name[0] == '/' ? "" : "/", shm_name);
+}
+
+// Abre un segmento existente (shm_open o hugetlbfs). Devuelve el descriptor o -1.
+static inline int segmento_abrir(const char *shm_name, int oflag) {
+    int fd = shm_open(shm_name, oflag, 0666);
+    if (fd != -1 || errno != ENOENT) return fd;
+    char ruta[512];
+    segmento_ruta_hugetlbfs(shm_name, ruta, sizeof(ruta));
+    return open(ruta, oflag);
+}
+
+// Crea el segmento segun el tipo de paginas. Devuelve el descriptor o -1.
+static inline int segmento_crear(const char *shm_name, int tipo_paginas) {
+    if (tipo_paginas != PAGINAS_HUGETLB) return shm_open(shm_name, O_CREAT | O_RDWR, 0666);
+    char ruta[512];
+    segmento_ruta_hugetlbfs(shm_name, ruta, sizeof(ruta));
+    return open(ruta, O_CREAT | O_RDWR, 0666);
+}
+
+// Borra el segmento donde sea que este
+static inline void segmento_eliminar(const char *shm_name) {
+    char ruta[512];
+    shm_unlink(shm_name);
+    segmento_ruta_hugetlbfs(shm_name, ruta, sizeof(ruta));
+    unlink(ruta);
+}
+
+// Tamano de pagina del sistema de archivos del descriptor (2 MiB o 1 GiB en hugetlbfs)
+static inline long segmento_tam_pagina_fs(int fd) {
+    struct statfs info;
+    if (fstatfs(fd, &info) == -1) return -1;
+    return (long)info.f_bsize;
+}
+
+// Tamano de una pagina grande transparente (PMD), 2 MiB si no se puede leer
+static inline long segmento_tam_thp(void) {
+    long tam = 2048 * 1024;
+    FILE *f = fopen("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "r");
+    if (f == NULL) return tam;
+    if (fscanf(f, "%ld", &tam) != 1) tam = 2048 * 1024;
+    fclose(f);
+    return tam;
+}
+
+// Mapea en la tabla de paginas del proceso todo el rango. Con MADV_POPULATE_WRITE
+// (Linux 5.14) lo hace el kernel en una llamada; si no, se toca una vez cada pagina.
+static inline void segmento_prefaltear(void *direccion, size_t tam, long tam_pagina) {
+#ifdef MADV_POPULATE_WRITE
+    if (madvise(direccion, tam, MADV_POPULATE_WRITE) == 0) return;
+#endif
+    volatile unsigned char *p = (volatile unsigned char *)direccion;
+    for (size_t i = 0; i < tam; i += tam_pagina) (void)p[i];
+}
+
+// Lado trabajador: repite en su propio mapeo los consejos del inicializador para
+// que el primer recorrido del anillo no tome fallos de pagina en el bucle caliente
+static inline void segmento_preparar(struct MemoriaCompartida *memoria, size_t tam) {
+    if (memoria->tipo_paginas == PAGINAS_THP) madvise(memoria, tam, MADV_HUGEPAGE);
+    if (memoria->prefault) segmento_prefaltear(memoria, tam, sysconf(_SC_PAGESIZE));
+}
+
+// Lee de /proc/self/smaps el tamano de pagina del mapeo que contiene 'direccion'
+// y cuantos kB estan mapeados con paginas grandes transparentes (ShmemPmdMapped)
+static inline int segmento_paginas_reales(const void *direccion, long *pagina_kb, long *thp_kb) {
+    FILE *smaps = fopen("/proc/self/smaps", "r");
+    if (smaps == NULL) return -1;
+    char linea[256];
+    int dentro = 0, encontrado = 0;
+    *pagina_kb = 0;
+    *thp_kb = 0;
+    while (fgets(linea, sizeof(linea), smaps) != NULL) {
+        unsigned long inicio, fin;
+        if (sscanf(linea, "%lx-%lx ", &inicio, &fin) == 2) {
+            if (dentro) break;
+            dentro = (unsigned long)direccion >= inicio && (unsigned long)direccion < fin;
+            continue;
+        }
+        if (!dentro) continue;
+        encontrado = 1;
+        sscanf(linea, "KernelPageSize: %ld kB", pagina_kb);
+        sscanf(linea, "ShmemPmdMapped: %ld kB", thp_kb);
+    }
+    fclose(smaps);
+    return encontrado ? 0 : -1;
+}
+
+#endif // SEGMENTO_H
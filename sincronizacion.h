@@ -0,0 +1,535 @@
+#ifndef SINCRONIZACION_H
+#define SINCRONIZACION_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>          // Para O_CREAT
+#include <unistd.h>         // Para syscall
+#include <semaphore.h>      // Para sem_open, sem_wait, sem_post
+#include <pthread.h>        // Para los mutex robustos de SYNC_ROBUSTO
+#include <signal.h>         // Para kill (deteccion de trabajadores muertos)
+#include <time.h>           // Para clock_gettime
+#include <stdatomic.h>
+#include <sys/syscall.h>    // Para SYS_futex
+#include <linux/futex.h>    // Para FUTEX_WAIT, FUTEX_WAKE
+#include "memInfo.h"
+
+// Capa de sincronizacion de emisores, receptores y finalizador. Cada uno de
+// los seis semaforos del sistema (mutex, prod, cons, empty, full, fin) es un
+// struct Semaforo que, segun memoria->backend_sync, es:
+//   SYNC_SEMAFOROS: un semaforo POSIX con nombre (<id>_mutex, <id>_full, ...)
+//   SYNC_FUTEX:     un contador dentro de MemoriaCompartida con espera futex(2),
+//                   precedida de un giro adaptativo acotado por presupuesto_espera
+//   SYNC_ROBUSTO:   un struct SemRobusto dentro de MemoriaCompartida (mutex robusto
+//                   compartido entre procesos). Si un trabajador muere con uno tomado,
+//                   el siguiente que lo toma recibe EOWNERDEAD y repara el estado en
+//                   lugar de quedar bloqueado para siempre
+
+// Definida en cada programa
+void reportar_error_y_salir(const char *msg);
+
+// Pausa de CPU dentro de los giros de espera
+#if defined(__x86_64__) || defined(__i386__)
+#define PAUSA_CPU() __builtin_ia32_pause()
+#else
+#define PAUSA_CPU() atomic_signal_fence(memory_order_seq_cst)
+#endif
+
+struct Semaforo {
+    sem_t *sem;                     // SYNC_SEMAFOROS
+    struct SemFutex *futex;         // SYNC_FUTEX
+    struct SemRobusto *robusto;     // SYNC_ROBUSTO
+    struct MemoriaCompartida *memoria;  // SYNC_ROBUSTO: estado a reparar tras EOWNERDEAD
+    int cual;                       // SYNC_MUTEX, SYNC_PROD, ...
+    int presupuesto_espera;         // Maximo de vueltas de giro antes de dormir
+};
+
+struct Sincronizacion {
+    struct Semaforo mutex;          // Registro de procesos y bandera de cierre
+    struct Semaforo prod;           // Lock de emisores
+    struct Semaforo cons;           // Lock de receptores
+    struct Semaforo empty;          // Espacios libres del buffer
+    struct Semaforo full;           // Espacios llenos del buffer
+    struct Semaforo fin;            // Aviso del ultimo proceso al finalizador
+};
+
+// --- Primitivas futex ---
+// Sin FUTEX_PRIVATE_FLAG: los contadores se comparten entre procesos
+static inline long futex_esperar(_Atomic int *direccion, int esperado) {
+    return syscall(SYS_futex, direccion, FUTEX_WAIT, esperado, NULL, NULL, 0);
+}
+
+// Como futex_esperar, pero se rinde tras 'plazo_ns' (el plazo de FUTEX_WAIT es relativo)
+static inline long futex_esperar_plazo(_Atomic int *direccion, int esperado, long plazo_ns) {
+    struct timespec plazo = { plazo_ns / 1000000000L, plazo_ns % 1000000000L };
+    return syscall(SYS_futex, direccion, FUTEX_WAIT, esperado, &plazo, NULL, 0);
+}
+
+static inline long futex_despertar(_Atomic int *direccion, int cantidad) {
+    return syscall(SYS_futex, direccion, FUTEX_WAKE, cantidad, NULL, NULL, 0);
+}
+
+// Intenta decrementar el contador sin bloquear
+static inline int sem_futex_intentar(struct SemFutex *f) {
+    int valor = atomic_load_explicit(&f->valor, memory_order_relaxed);
+    while (valor > 0) {
+        if (atomic_compare_exchange_weak_explicit(&f->valor, &valor, valor - 1,
+                                                  memory_order_acquire, memory_order_relaxed)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Gira un numero adaptativo de vueltas (crece si girar suele bastar y se
+// reduce si no) y luego duerme en el futex hasta que el contador sea positivo.
+static inline int sem_futex_esperar(struct SemFutex *f, int presupuesto) {
+    int giro = atomic_load_explicit(&f->giro_adaptativo, memory_order_relaxed);
+    if (giro > presupuesto) giro = presupuesto;
+
+    for (int i = 0; i < giro; i++) {
+        if (sem_futex_intentar(f)) {
+            int nuevo = giro * 2 + 1;
+            atomic_store_explicit(&f->giro_adaptativo, nuevo > presupuesto ? presupuesto : nuevo, memory_order_relaxed);
+            return 0;
+        }
+        PAUSA_CPU();
+    }
+    atomic_store_explicit(&f->giro_adaptativo, giro / 2, memory_order_relaxed);
+
+    for (;;) {
+        if (sem_futex_intentar(f)) return 0;
+
+        // Anunciarse antes de dormir: quien haga post vera esperando > 0 y despertara.
+        // Si el contador cambio entre medio, FUTEX_WAIT vuelve de inmediato con EAGAIN.
+        atomic_fetch_add(&f->esperando, 1);
+        long r = futex_esperar(&f->valor, 0);
+        int err = errno;
+        atomic_fetch_sub(&f->esperando, 1);
+        if (r == -1 && err == EINTR) {
+            errno = EINTR;
+            return -1;
+        }
+    }
+}
+
+static inline int sem_futex_senalar(struct SemFutex *f) {
+    atomic_fetch_add(&f->valor, 1);
+    if (atomic_load(&f->esperando) > 0) {
+        if (futex_despertar(&f->valor, 1) == -1) return -1;
+    }
+    return 0;
+}
+
+// --- Primitivas SYNC_ROBUSTO ---
+#define ROBUSTO_ESPERA_MS 50        // Tope de cada espera en el futex (ver sem_robusto_esperar)
+
+static inline int sincronizacion_es_lock(int cual) {
+    return cual == SYNC_MUTEX || cual == SYNC_PROD || cual == SYNC_CONS;
+}
+
+// Inicializador: mutex robusto compartido entre procesos
+static inline void sem_robusto_crear(struct SemRobusto *r, int valor) {
+    pthread_mutexattr_t atributos;
+    pthread_mutexattr_init(&atributos);
+    pthread_mutexattr_setpshared(&atributos, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&atributos, PTHREAD_MUTEX_ROBUST);
+    int err = pthread_mutex_init(&r->mutex, &atributos);
+    pthread_mutexattr_destroy(&atributos);
+    if (err != 0) { errno = err; reportar_error_y_salir("pthread_mutex_init (robusto)"); }
+
+    atomic_init(&r->secuencia, 0);
+    r->valor = valor;
+    r->esperando = 0;
+    atomic_init(&r->recuperaciones, 0);
+}
+
+// Suma uno al contador 'cual' (SYNC_EMPTY o SYNC_FULL) en nombre de un trabajador muerto
+static inline void sem_robusto_devolver(struct MemoriaCompartida *memoria, int cual) {
+    struct SemRobusto *r = &memoria->sync_robusto[cual];
+    if (pthread_mutex_lock(&r->mutex) == EOWNERDEAD) pthread_mutex_consistent(&r->mutex);
+    r->valor++;
+    atomic_fetch_add(&r->secuencia, 1);
+    if (r->esperando > 0) futex_despertar(&r->secuencia, 1);
+    pthread_mutex_unlock(&r->mutex);
+}
+
+// Con sem_mutex tomado: da de baja a los trabajadores registrados en la tabla de
+// metricas que ya no existen y devuelve al anillo el espacio que cada uno tenia
+// tomado (su 'credito'). Devuelve cuantos encontro.
+static inline int sincronizacion_purgar_muertos(struct MemoriaCompartida *memoria) {
+    int purgados = 0;
+    for (int i = 0; i < MAX_TRABAJADORES_METRICAS; i++) {
+        struct MetricasTrabajador *m = &memoria->metricas[i];
+        int pid = atomic_load(&m->pid);
+        if (pid == 0 || !atomic_load(&m->activo)) continue;
+        if (kill(pid, 0) == 0 || errno != ESRCH) continue;
+        atomic_store(&m->activo, 0);
+        if (m->tipo == TRABAJADOR_EMISOR) memoria->emisores_activos--;
+        else memoria->receptores_activos--;
+        // 'credito' queda como estaba: sincronizacion_reparar aun puede necesitarlo
+        int credito = atomic_load(&m->credito);
+        if (memoria->backend_sync == SYNC_ROBUSTO && (credito == SYNC_EMPTY || credito == SYNC_FULL)) {
+            sem_robusto_devolver(memoria, credito);
+        }
+        purgados++;
+    }
+    memoria->trabajadores_purgados += purgados;
+    return purgados;
+}
+
+static inline int sem_robusto_tomar(struct Semaforo *s);
+
+// Se tomo 's' con EOWNERDEAD: su dueno murio dentro de la seccion critica.
+//   prod/cons: si el muerto no llego a confirmar la escritura/lectura del anillo, se
+//              restauran los indices y contadores guardados al empezar, asi la celda
+//              se vuelve a escribir/leer
+//   todos:     se da de baja a los trabajadores muertos (devolviendo el espacio que
+//              tenian tomado) para que el cierre no los espere
+// Las reservas de rango del archivo son una sola escritura: no quedan a medias.
+static inline void sincronizacion_reparar(struct Semaforo *s) {
+    struct MemoriaCompartida *memoria = s->memoria;
+    atomic_fetch_add(&s->robusto->recuperaciones, 1);
+    fprintf(stderr, "Aviso (PID %d): el dueno del lock %d murio con el tomado; se repara el estado.\n",
+            id_trabajador(), s->cual);
+
+    struct RegistroDeshacer *d = NULL;
+    int tomado = 0;
+    if (s->cual == SYNC_PROD) {
+        d = &memoria->productores.deshacer;
+        tomado = SYNC_EMPTY;
+    } else if (s->cual == SYNC_CONS) {
+        d = &memoria->consumidores.deshacer;
+        tomado = SYNC_FULL;
+    }
+    // Con ranura, la seccion se confirma cuando el credito del dueno deja de ser el
+    // espacio que tomo (ver sincronizacion_deshacer_confirmar)
+    int a_medias = d != NULL && d->activo &&
+                   (d->ranura < 0 || atomic_load(&memoria->metricas[d->ranura].credito) == tomado);
+    if (a_medias && s->cual == SYNC_PROD) {
+        memoria->productores.idx_escritura = d->idx;
+        atomic_store(&memoria->productores.celdas_escritas, d->celdas);
+        atomic_store(&memoria->productores.total_producidos, d->total);
+    } else if (a_medias) {
+        memoria->consumidores.idx_lectura = d->idx;
+        atomic_store(&memoria->consumidores.celdas_leidas, d->celdas);
+        atomic_store(&memoria->consumidores.idx_archivo_escritura, d->archivo);
+        atomic_store(&memoria->consumidores.total_consumidos, d->total);
+    }
+    // Sin ranura nadie va a purgarlo: el espacio se devuelve aqui
+    if (a_medias && d->ranura < 0) sem_robusto_devolver(memoria, tomado);
+    if (d != NULL) d->activo = 0;
+
+    // Nadie toma prod o cons con sem_mutex tomado: este orden no puede trabarse
+    if (s->cual == SYNC_MUTEX) {
+        sincronizacion_purgar_muertos(memoria);
+    } else {
+        struct Semaforo mutex = *s;
+        mutex.robusto = &memoria->sync_robusto[SYNC_MUTEX];
+        mutex.cual = SYNC_MUTEX;
+        if (sem_robusto_tomar(&mutex) == 0) {
+            sincronizacion_purgar_muertos(memoria);
+            mutex.robusto->valor = 1;
+            pthread_mutex_unlock(&mutex.robusto->mutex);
+        }
+    }
+}
+
+// Toma el mutex; si su dueno murio, repara (solo los locks) y lo marca consistente
+static inline int sem_robusto_tomar(struct Semaforo *s) {
+    int err = pthread_mutex_lock(&s->robusto->mutex);
+    if (err == EOWNERDEAD) {
+        // En los contadores el muerto solo cambiaba 'valor': queda antes o despues del cambio
+        if (sincronizacion_es_lock(s->cual)) sincronizacion_reparar(s);
+        else atomic_fetch_add(&s->robusto->recuperaciones, 1);
+        err = pthread_mutex_consistent(&s->robusto->mutex);
+    }
+    if (err != 0) {
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+// Purga a los muertos si sem_mutex esta libre (no espera a nadie)
+static inline void sincronizacion_purgar_si_libre(struct MemoriaCompartida *memoria) {
+    struct Semaforo mutex = { .robusto = &memoria->sync_robusto[SYNC_MUTEX], .memoria = memoria, .cual = SYNC_MUTEX };
+    int err = pthread_mutex_trylock(&mutex.robusto->mutex);
+    if (err == EOWNERDEAD) {
+        sincronizacion_reparar(&mutex);
+        err = pthread_mutex_consistent(&mutex.robusto->mutex);
+    }
+    if (err != 0) return;
+    sincronizacion_purgar_muertos(memoria);
+    mutex.robusto->valor = 1;
+    pthread_mutex_unlock(&mutex.robusto->mutex);
+}
+
+// Contadores: espera hasta 'plazo_ms' (< 0 = sin limite) a que el valor sea positivo.
+// Cada espera en el futex dura a lo sumo ROBUSTO_ESPERA_MS: si un proceso muere
+// despues de que lo despertaran se lleva ese aviso, y asi el resto no depende de el.
+// Quien pasa un plazo entero sin espacio en empty/full busca muertos: alguno puede
+// haberse llevado espacio del anillo sin tener ningun lock tomado.
+static inline int sem_robusto_esperar(struct Semaforo *s, long plazo_ms) {
+    struct SemRobusto *r = s->robusto;
+    if (sem_robusto_tomar(s) == -1) return -1;
+    if (sincronizacion_es_lock(s->cual)) {
+        r->valor = 0;
+        return 0;       // El lock queda tomado hasta semaforo_senalar
+    }
+
+    struct timespec ahora;
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    long limite_ns = plazo_ms < 0 ? -1 : ahora.tv_sec * 1000000000L + ahora.tv_nsec + plazo_ms * 1000000L;
+    while (r->valor == 0) {
+        clock_gettime(CLOCK_MONOTONIC, &ahora);
+        long ahora_ns = ahora.tv_sec * 1000000000L + ahora.tv_nsec;
+        if (limite_ns >= 0 && ahora_ns >= limite_ns) {
+            pthread_mutex_unlock(&r->mutex);
+            errno = ETIMEDOUT;
+            return -1;
+        }
+        long plazo_ns = ROBUSTO_ESPERA_MS * 1000000L;
+        if (limite_ns >= 0 && limite_ns - ahora_ns < plazo_ns) plazo_ns = limite_ns - ahora_ns;
+        int secuencia = atomic_load(&r->secuencia);
+        r->esperando++;
+        pthread_mutex_unlock(&r->mutex);
+        long res = futex_esperar_plazo(&r->secuencia, secuencia, plazo_ns);
+        if (res == -1 && errno == ETIMEDOUT && (s->cual == SYNC_EMPTY || s->cual == SYNC_FULL)) {
+            sincronizacion_purgar_si_libre(s->memoria);
+        }
+        if (sem_robusto_tomar(s) == -1) return -1;
+        r->esperando--;
+    }
+    r->valor--;
+    pthread_mutex_unlock(&r->mutex);
+    return 0;
+}
+
+static inline int sem_robusto_senalar(struct Semaforo *s) {
+    struct SemRobusto *r = s->robusto;
+    if (sincronizacion_es_lock(s->cual)) {
+        r->valor = 1;
+        int err = pthread_mutex_unlock(&r->mutex);
+        if (err != 0) { errno = err; return -1; }
+        return 0;
+    }
+    if (sem_robusto_tomar(s) == -1) return -1;
+    r->valor++;
+    atomic_fetch_add(&r->secuencia, 1);
+    if (r->esperando > 0) futex_despertar(&r->secuencia, 1);
+    pthread_mutex_unlock(&r->mutex);
+    return 0;
+}
+
+static inline int sem_robusto_intentar(struct Semaforo *s) {
+    struct SemRobusto *r = s->robusto;
+    if (sincronizacion_es_lock(s->cual)) {
+        int err = pthread_mutex_trylock(&r->mutex);
+        if (err == EOWNERDEAD) {
+            sincronizacion_reparar(s);
+            err = pthread_mutex_consistent(&r->mutex);
+        }
+        if (err != 0) { errno = err == EBUSY ? EAGAIN : err; return -1; }
+        r->valor = 0;
+        return 0;
+    }
+    if (sem_robusto_tomar(s) == -1) return -1;
+    int tomado = r->valor > 0;
+    if (tomado) r->valor--;
+    pthread_mutex_unlock(&r->mutex);
+    if (!tomado) { errno = EAGAIN; return -1; }
+    return 0;
+}
+
+// Espacio del anillo de ANILLO_SEMAFOROS que el trabajador tiene tomado, para que la
+// purga lo devuelva si muere: SYNC_EMPTY / SYNC_FULL al salir de la espera y 0 justo
+// antes de senalar. Solo SYNC_ROBUSTO lo necesita (los demas no se reparan).
+static inline void sincronizacion_credito(struct MemoriaCompartida *memoria, struct MetricasTrabajador *m,
+                                          int credito) {
+    if (memoria->backend_sync != SYNC_ROBUSTO || memoria->protocolo_anillo != ANILLO_SEMAFOROS) return;
+    atomic_store(&m->credito, credito);
+}
+
+// Secciones del anillo de ANILLO_SEMAFOROS: se guarda el estado antes de modificarlo
+// y se descarta al terminar.
+static inline void sincronizacion_deshacer_guardar(struct MemoriaCompartida *memoria, int cual,
+                                                   struct MetricasTrabajador *m) {
+    if (memoria->backend_sync != SYNC_ROBUSTO) return;
+    struct RegistroDeshacer *d;
+    if (cual == SYNC_PROD) {
+        d = &memoria->productores.deshacer;
+        d->idx = memoria->productores.idx_escritura;
+        d->celdas = atomic_load_explicit(&memoria->productores.celdas_escritas, memory_order_relaxed);
+        d->total = atomic_load_explicit(&memoria->productores.total_producidos, memory_order_relaxed);
+    } else {
+        d = &memoria->consumidores.deshacer;
+        d->idx = memoria->consumidores.idx_lectura;
+        d->celdas = atomic_load_explicit(&memoria->consumidores.celdas_leidas, memory_order_relaxed);
+        d->archivo = atomic_load_explicit(&memoria->consumidores.idx_archivo_escritura, memory_order_relaxed);
+        d->total = atomic_load_explicit(&memoria->consumidores.total_consumidos, memory_order_relaxed);
+    }
+    // Una ranura descartable (tabla llena) no la ve la purga
+    long ranura = m - memoria->metricas;
+    d->ranura = ranura >= 0 && ranura < MAX_TRABAJADORES_METRICAS ? (int)ranura : -1;
+    atomic_signal_fence(memory_order_seq_cst);
+    d->activo = 1;
+    atomic_signal_fence(memory_order_seq_cst);
+}
+
+// Confirma la seccion con un solo store: el credito pasa del espacio tomado al que hay
+// que senalar (prod: de empty a full; cons: de full a empty)
+static inline void sincronizacion_deshacer_confirmar(struct MemoriaCompartida *memoria, int cual,
+                                                     struct MetricasTrabajador *m) {
+    if (memoria->backend_sync != SYNC_ROBUSTO) return;
+    atomic_signal_fence(memory_order_seq_cst);
+    atomic_store(&m->credito, cual == SYNC_PROD ? SYNC_FULL : SYNC_EMPTY);
+    if (cual == SYNC_PROD) memoria->productores.deshacer.activo = 0;
+    else memoria->consumidores.deshacer.activo = 0;
+}
+
+// --- Operaciones genericas (misma convencion que sem_wait/sem_post: -1 y errno) ---
+static inline int semaforo_esperar(struct Semaforo *s) {
+    if (s->futex != NULL) return sem_futex_esperar(s->futex, s->presupuesto_espera);
+    if (s->robusto != NULL) return sem_robusto_esperar(s, -1);
+    return sem_wait(s->sem);
+}
+
+static inline int semaforo_senalar(struct Semaforo *s) {
+    if (s->futex != NULL) return sem_futex_senalar(s->futex);
+    if (s->robusto != NULL) return sem_robusto_senalar(s);
+    return sem_post(s->sem);
+}
+
+// Como semaforo_esperar, pero con SYNC_ROBUSTO se rinde a los 'plazo_ms' (-1 y ETIMEDOUT).
+// Los otros backends esperan sin limite: ahi un trabajador muerto no se puede purgar.
+static inline int semaforo_esperar_plazo(struct Semaforo *s, long plazo_ms) {
+    if (s->robusto != NULL) return sem_robusto_esperar(s, plazo_ms);
+    return semaforo_esperar(s);
+}
+
+// Decrementa sin bloquear: 0 si lo logro, -1 si el valor era 0
+static inline int semaforo_intentar(struct Semaforo *s) {
+    if (s->futex != NULL) return sem_futex_intentar(s->futex) ? 0 : -1;
+    if (s->robusto != NULL) return sem_robusto_intentar(s);
+    return sem_trywait(s->sem);
+}
+
+// Valor actual del semaforo (solo informativo: puede cambiar al instante)
+static inline int semaforo_valor(struct Semaforo *s) {
+    if (s->futex != NULL) return atomic_load_explicit(&s->futex->valor, memory_order_relaxed);
+    if (s->robusto != NULL) return s->robusto->valor;
+    int valor = 0;
+    sem_getvalue(s->sem, &valor);
+    return valor;
+}
+
+// Modo hilos: sustituye 's' por un semaforo sin nombre privado del proceso. Solo es
+// valido si todos los que lo usan son hilos de este proceso (p. ej. sem_prod cuando
+// todos los emisores son hilos del mismo lanzador). 'original' permite restaurarlo.
+static inline void semaforo_privatizar(struct Semaforo *s, sem_t *privado, unsigned int valor, struct Semaforo *original) {
+    if (sem_init(privado, 0, valor) == -1) reportar_error_y_salir("sem_init (privado)");
+    *original = *s;
+    s->sem = privado;
+    s->futex = NULL;
+    s->robusto = NULL;
+}
+
+static inline void semaforo_restaurar(struct Semaforo *s, sem_t *privado, const struct Semaforo *original) {
+    sem_destroy(privado);
+    *s = *original;
+}
+
+// --- Nombres de los semaforos POSIX ---
+static inline void sincronizacion_nombre(char *destino, size_t tam, const char *shm_name, const char *sufijo) {
+    int r = snprintf(destino, tam, "%s%s", shm_name, sufijo);
+    if (r < 0 || (size_t)r >= tam) {
+        fprintf(stderr, "Error: nombre de semaforo '%s%s' truncado (necesario=%d, tam=%zu)\n", shm_name, sufijo, r, tam);
+        exit(EXIT_FAILURE);
+    }
+}
+
+static const char *const SUFIJOS_SEMAFOROS[SYNC_TOTAL] = {
+    SEM_MUTEX_NAME_SUFFIX, SEM_PROD_NAME_SUFFIX, SEM_CONS_NAME_SUFFIX,
+    SEM_EMPTY_NAME_SUFFIX, SEM_FULL_NAME_SUFFIX, SEM_FIN_NAME_SUFFIX
+};
+
+static inline struct Semaforo *sincronizacion_semaforo(struct Sincronizacion *sync, int cual) {
+    struct Semaforo *todos[SYNC_TOTAL] = { &sync->mutex, &sync->prod, &sync->cons, &sync->empty, &sync->full, &sync->fin };
+    return todos[cual];
+}
+
+// Abre (o, si valores_iniciales != NULL, crea) los seis semaforos
+static inline void sincronizacion_preparar(struct Sincronizacion *sync, const char *shm_name,
+                                           struct MemoriaCompartida *memoria, const int *valores_iniciales) {
+    for (int i = 0; i < SYNC_TOTAL; i++) {
+        struct Semaforo *s = sincronizacion_semaforo(sync, i);
+        s->sem = NULL;
+        s->futex = NULL;
+        s->robusto = NULL;
+        s->memoria = memoria;
+        s->cual = i;
+        s->presupuesto_espera = memoria->presupuesto_espera;
+
+        if (memoria->backend_sync == SYNC_ROBUSTO) {
+            s->robusto = &memoria->sync_robusto[i];
+            if (valores_iniciales != NULL) sem_robusto_crear(s->robusto, valores_iniciales[i]);
+            continue;
+        }
+
+        if (memoria->backend_sync == SYNC_FUTEX) {
+            s->futex = &memoria->sync_futex[i];
+            if (valores_iniciales != NULL) {
+                atomic_init(&s->futex->valor, valores_iniciales[i]);
+                atomic_init(&s->futex->esperando, 0);
+                atomic_init(&s->futex->giro_adaptativo, memoria->presupuesto_espera);
+            }
+            continue;
+        }
+
+        char nombre[512];
+        sincronizacion_nombre(nombre, sizeof(nombre), shm_name, SUFIJOS_SEMAFOROS[i]);
+        s->sem = (valores_iniciales != NULL) ? sem_open(nombre, O_CREAT, 0666, valores_iniciales[i]) : sem_open(nombre, 0);
+        if (s->sem == SEM_FAILED) {
+            fprintf(stderr, "Error en sem_open (%s)\n", SUFIJOS_SEMAFOROS[i] + 1);
+            reportar_error_y_salir("sem_open");
+        }
+    }
+}
+
+// Inicializador: crea los semaforos con sus valores iniciales
+static inline void sincronizacion_crear(struct Sincronizacion *sync, const char *shm_name, struct MemoriaCompartida *memoria) {
+    int valores_iniciales[SYNC_TOTAL];
+    valores_iniciales[SYNC_MUTEX] = 1;
+    valores_iniciales[SYNC_PROD] = 1;
+    valores_iniciales[SYNC_CONS] = 1;
+    valores_iniciales[SYNC_EMPTY] = memoria->buffer_size;
+    valores_iniciales[SYNC_FULL] = 0;
+    valores_iniciales[SYNC_FIN] = 0;
+    sincronizacion_preparar(sync, shm_name, memoria, valores_iniciales);
+}
+
+// Emisores, receptores y finalizador: se conectan a semaforos ya creados
+static inline void sincronizacion_abrir(struct Sincronizacion *sync, const char *shm_name, struct MemoriaCompartida *memoria) {
+    sincronizacion_preparar(sync, shm_name, memoria, NULL);
+}
+
+static inline void sincronizacion_cerrar(struct Sincronizacion *sync) {
+    for (int i = 0; i < SYNC_TOTAL; i++) {
+        struct Semaforo *s = sincronizacion_semaforo(sync, i);
+        if (s->sem != NULL) sem_close(s->sem);
+        s->sem = NULL;
+    }
+}
+
+// Borra los semaforos con nombre del sistema (no falla si no existen)
+static inline void sincronizacion_eliminar(const char *shm_name) {
+    for (int i = 0; i < SYNC_TOTAL; i++) {
+        char nombre[512];
+        sincronizacion_nombre(nombre, sizeof(nombre), shm_name, SUFIJOS_SEMAFOROS[i]);
+        sem_unlink(nombre);
+    }
+}
+
+#endif // SINCRONIZACION_H
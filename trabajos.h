@@ -0,0 +1,223 @@
+#ifndef TRABAJOS_H
+#define TRABAJOS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>          // Para O_CREAT, O_RDWR
+#include <unistd.h>         // Para ftruncate, close, truncate
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "memInfo.h"
+#include "sincronizacion.h"
+
+// Modo manifiesto (--manifiesto): en vez de una sola fuente, el pipeline procesa
+// una tabla de trabajos (fuente, salida, longitud y progreso) que vive en el
+// segmento aparte <shm_id>_trabajos. Los emisores reclaman rangos del trabajo en
+// curso y pasan al siguiente cuando se agota, asi que varios archivos chicos se
+// procesan a la vez; cada unidad lleva el numero de su trabajo y el receptor la
+// escribe en la salida de ese trabajo. Emisores y receptores siguen vivos entre
+// archivos.
+//
+// Fin de un trabajo:
+//   rangos_abiertos arranca en 1 (la "lectura pendiente"); cada rango reclamado
+//   suma 1 salvo el ultimo, que hereda ese 1. Quien lo deja en 0 ya produjo todo:
+//   marca 'leido'. El trabajo queda completo cuando esta leido y consumidos ==
+//   producidos; lo detecta el emisor al marcarlo o el receptor al consumir, y un
+//   CAS sobre 'estado' elige a uno solo para recortar la salida.
+
+#define TRABAJO_PENDIENTE 0
+#define TRABAJO_EN_CURSO  1
+#define TRABAJO_LEIDO     2         // Todo producido; faltan unidades por consumir
+#define TRABAJO_COMPLETO  3
+
+struct Trabajo {
+    char fuente[256];
+    char salida[256];
+    long tam;                       // Longitud de la fuente (bytes)
+    long idx_lectura;               // Proximo byte a reclamar (protegido por sem_prod)
+
+    _Alignas(TAM_LINEA_CACHE) _Atomic int estado;
+    _Atomic int rangos_abiertos;
+    _Atomic long producidos;        // Bytes encolados (sin saltos de linea)
+    _Atomic long consumidos;        // Bytes escritos por los receptores
+    _Atomic long idx_salida;        // Proxima posicion libre del archivo de salida
+};
+
+struct TablaTrabajos {
+    int num_trabajos;
+    int trabajo_actual;             // Primer trabajo con bytes sin reclamar (protegido por sem_prod)
+    _Atomic int trabajos_completos;
+    _Alignas(TAM_LINEA_CACHE) struct Trabajo trabajos[];
+};
+
+static inline size_t trabajos_tam_segmento(int num_trabajos) {
+    return sizeof(struct TablaTrabajos) + (size_t)num_trabajos * sizeof(struct Trabajo);
+}
+
+static inline void trabajos_nombre(char *destino, size_t tam, const char *shm_name) {
+    sincronizacion_nombre(destino, tam, shm_name, SHM_TRABAJOS_NAME_SUFFIX);
+}
+
+// Cuenta los trabajos del manifiesto: una linea "<fuente> <salida>" por trabajo;
+// se ignoran las lineas vacias y las que empiezan con '#'. Devuelve -1 si hay errores.
+static inline int trabajos_leer_manifiesto(const char *ruta, struct Trabajo *destino) {
+    FILE *archivo = fopen(ruta, "r");
+    if (archivo == NULL) {
+        fprintf(stderr, "Error al abrir el manifiesto: %s\n", ruta);
+        return -1;
+    }
+    char linea[1024], fuente[256], salida[256];
+    int n = 0, numero_linea = 0, errores = 0;
+    while (fgets(linea, sizeof(linea), archivo) != NULL) {
+        numero_linea++;
+        char *inicio = linea + strspn(linea, " \t");
+        if (*inicio == '#' || *inicio == '\n' || *inicio == '\0') continue;
+        if (sscanf(inicio, "%255s %255s", fuente, salida) != 2) {
+            fprintf(stderr, "Manifiesto %s:%d: se esperaba '<fuente> <salida>'.\n", ruta, numero_linea);
+            errores++;
+            continue;
+        }
+        struct stat info;
+        if (stat(fuente, &info) == -1 || !S_ISREG(info.st_mode)) {
+            fprintf(stderr, "Manifiesto %s:%d: '%s' no es un archivo regular.\n", ruta, numero_linea, fuente);
+            errores++;
+            continue;
+        }
+        if (destino != NULL) {
+            struct Trabajo *t = &destino[n];
+            memset(t, 0, sizeof(*t));
+            snprintf(t->fuente, sizeof(t->fuente), "%s", fuente);
+            snprintf(t->salida, sizeof(t->salida), "%s", salida);
+            t->tam = info.st_size;
+        }
+        n++;
+    }
+    fclose(archivo);
+    return errores > 0 ? -1 : n;
+}
+
+// Inicializador: crea la tabla a partir del manifiesto. Devuelve NULL si el manifiesto es invalido.
+// Con ORDEN_FUENTE la salida de cada trabajo ocupa lo mismo que su fuente: idx_salida arranca en tam.
+static inline struct TablaTrabajos *trabajos_crear(const char *shm_name, const char *manifiesto, int orden_salida,
+                                                   size_t *tam) {
+    int n = trabajos_leer_manifiesto(manifiesto, NULL);
+    if (n <= 0) {
+        if (n == 0) fprintf(stderr, "El manifiesto %s no tiene trabajos.\n", manifiesto);
+        return NULL;
+    }
+
+    char nombre[512];
+    trabajos_nombre(nombre, sizeof(nombre), shm_name);
+    int fd = shm_open(nombre, O_CREAT | O_RDWR, 0666);
+    if (fd == -1) reportar_error_y_salir("shm_open (trabajos)");
+    *tam = trabajos_tam_segmento(n);
+    if (ftruncate(fd, *tam) == -1) reportar_error_y_salir("ftruncate (trabajos)");
+    struct TablaTrabajos *tabla = mmap(NULL, *tam, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (tabla == MAP_FAILED) reportar_error_y_salir("mmap (trabajos)");
+    close(fd);
+
+    tabla->num_trabajos = n;
+    tabla->trabajo_actual = 0;
+    atomic_init(&tabla->trabajos_completos, 0);
+    if (trabajos_leer_manifiesto(manifiesto, tabla->trabajos) != n) {
+        fprintf(stderr, "El manifiesto %s cambio mientras se leia.\n", manifiesto);
+        return NULL;
+    }
+    for (int i = 0; i < n; i++) {
+        struct Trabajo *t = &tabla->trabajos[i];
+        atomic_init(&t->rangos_abiertos, 1);
+        atomic_init(&t->idx_salida, orden_salida == ORDEN_FUENTE ? t->tam : 0);
+        // Una fuente vacia ya esta completa: nadie reclamara rangos de ella
+        atomic_init(&t->estado, t->tam == 0 ? TRABAJO_COMPLETO : TRABAJO_PENDIENTE);
+        if (t->tam == 0) atomic_fetch_add(&tabla->trabajos_completos, 1);
+    }
+    return tabla;
+}
+
+static inline struct TablaTrabajos *trabajos_abrir(const char *shm_name, size_t *tam) {
+    char nombre[512];
+    trabajos_nombre(nombre, sizeof(nombre), shm_name);
+    int fd = shm_open(nombre, O_RDWR, 0666);
+    if (fd == -1) reportar_error_y_salir("shm_open (trabajos)");
+    struct stat info;
+    if (fstat(fd, &info) == -1) reportar_error_y_salir("fstat (trabajos)");
+    *tam = info.st_size;
+    struct TablaTrabajos *tabla = mmap(NULL, *tam, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (tabla == MAP_FAILED) reportar_error_y_salir("mmap (trabajos)");
+    close(fd);
+    return tabla;
+}
+
+static inline void trabajos_cerrar(struct TablaTrabajos *tabla, size_t tam) {
+    munmap(tabla, tam);
+}
+
+// Borra el segmento de la tabla (no falla si no existe)
+static inline void trabajos_eliminar(const char *shm_name) {
+    char nombre[512];
+    trabajos_nombre(nombre, sizeof(nombre), shm_name);
+    shm_unlink(nombre);
+}
+
+// --- Lado de los emisores ---
+
+// Reclama hasta 'cantidad' bytes del primer trabajo con bytes libres. Se llama con
+// sem_prod tomado. Devuelve el trabajo (y el rango en *inicio, *reclamados) o -1 si no queda nada.
+static inline int trabajos_reclamar(struct TablaTrabajos *tabla, long cantidad, long *inicio, long *reclamados) {
+    while (tabla->trabajo_actual < tabla->num_trabajos &&
+           tabla->trabajos[tabla->trabajo_actual].idx_lectura >= tabla->trabajos[tabla->trabajo_actual].tam) {
+        tabla->trabajo_actual++;
+    }
+    if (tabla->trabajo_actual == tabla->num_trabajos) return -1;
+
+    int id = tabla->trabajo_actual;
+    struct Trabajo *t = &tabla->trabajos[id];
+    if (t->tam - t->idx_lectura < cantidad) cantidad = t->tam - t->idx_lectura;
+    *inicio = t->idx_lectura;
+    *reclamados = cantidad;
+    t->idx_lectura += cantidad;
+    // El ultimo rango hereda la "lectura pendiente"; los demas abren uno nuevo
+    if (t->idx_lectura < t->tam) atomic_fetch_add(&t->rangos_abiertos, 1);
+    if (atomic_load_explicit(&t->estado, memory_order_relaxed) == TRABAJO_PENDIENTE) {
+        atomic_store(&t->estado, TRABAJO_EN_CURSO);
+    }
+    return id;
+}
+
+// Recorta la salida a lo escrito y cuenta el trabajo si este proceso gano el CAS
+static inline void trabajos_intentar_completar(struct TablaTrabajos *tabla, int id) {
+    struct Trabajo *t = &tabla->trabajos[id];
+    if (atomic_load(&t->estado) != TRABAJO_LEIDO) return;
+    if (atomic_load(&t->consumidos) != atomic_load(&t->producidos)) return;
+    int esperado = TRABAJO_LEIDO;
+    if (!atomic_compare_exchange_strong(&t->estado, &esperado, TRABAJO_COMPLETO)) return;
+    // La salida se pre-dimensiona al tamano de la fuente; lo que sobra son saltos de linea
+    truncate(t->salida, atomic_load(&t->idx_salida));
+    atomic_fetch_add(&tabla->trabajos_completos, 1);
+}
+
+// El emisor termino de encolar un rango del trabajo 'id'
+static inline void trabajos_cerrar_rango(struct TablaTrabajos *tabla, int id) {
+    struct Trabajo *t = &tabla->trabajos[id];
+    if (atomic_fetch_sub(&t->rangos_abiertos, 1) != 1) return;
+    atomic_store(&t->estado, TRABAJO_LEIDO);
+    trabajos_intentar_completar(tabla, id);
+}
+
+// --- Lado de los receptores ---
+
+// Reserva 'longitud' bytes en la salida del trabajo. Devuelve la posicion (solo ORDEN_LLEGADA).
+static inline long trabajos_posicion_salida(struct TablaTrabajos *tabla, int id, int longitud) {
+    return atomic_fetch_add_explicit(&tabla->trabajos[id].idx_salida, longitud, memory_order_relaxed);
+}
+
+// El receptor ya entrego 'longitud' bytes del trabajo a su motor de salida
+static inline void trabajos_consumir(struct TablaTrabajos *tabla, int id, int longitud) {
+    atomic_fetch_add(&tabla->trabajos[id].consumidos, longitud);
+    trabajos_intentar_completar(tabla, id);
+}
+
+#endif // TRABAJOS_H
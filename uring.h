@@ -0,0 +1,146 @@
+#ifndef URING_H
+#define URING_H
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>         // Para syscall
+#include <sys/mman.h>
+#include <sys/syscall.h>    // Para __NR_io_uring_setup, __NR_io_uring_enter
+#include <linux/io_uring.h>
+
+// Anillo io_uring minimo para el motor de salida SALIDA_URING, con las syscalls
+// directas (sin liburing, como futex y mbind). Solo prepara escrituras
+// posicionales, las envia por lotes y cosecha completados sin bloquear.
+//
+// Las colas se comparten con el kernel: las cabezas y colas se leen y escriben
+// con acquire/release porque el kernel las modifica desde su lado.
+
+struct Uring {
+    int fd;
+    unsigned entradas;
+
+    unsigned *sq_cabeza;            // Cola de envio (SQ): el kernel avanza la cabeza
+    unsigned *sq_cola;
+    unsigned *sq_mascara;
+    unsigned *sq_arreglo;
+    struct io_uring_sqe *sqes;
+    unsigned sq_cola_local;         // Entradas preparadas aun no publicadas al kernel
+    unsigned sin_enviar;            // Publicadas pero sin io_uring_enter
+
+    unsigned *cq_cabeza;            // Cola de completados (CQ): el kernel avanza la cola
+    unsigned *cq_cola;
+    unsigned *cq_mascara;
+    struct io_uring_cqe *cqes;
+
+    void *mapa_sq;
+    size_t tam_mapa_sq;
+    void *mapa_cq;                  // Igual a mapa_sq con IORING_FEAT_SINGLE_MMAP
+    size_t tam_mapa_cq;
+    size_t tam_sqes;
+};
+
+// Crea el anillo con 'entradas' espacios. Devuelve 0, o -1 con errno si el kernel
+// no soporta io_uring (ENOSYS) o lo tiene deshabilitado (EPERM).
+static inline int uring_crear(struct Uring *u, unsigned entradas) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    memset(u, 0, sizeof(*u));
+    u->fd = syscall(__NR_io_uring_setup, entradas, &p);
+    if (u->fd == -1) return -1;
+    u->entradas = p.sq_entries;
+
+    u->tam_mapa_sq = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    u->tam_mapa_cq = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    int un_mapeo = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (un_mapeo && u->tam_mapa_cq > u->tam_mapa_sq) u->tam_mapa_sq = u->tam_mapa_cq;
+
+    u->mapa_sq = mmap(NULL, u->tam_mapa_sq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQ_RING);
+    if (u->mapa_sq == MAP_FAILED) goto fallo;
+    if (un_mapeo) {
+        u->mapa_cq = u->mapa_sq;
+    } else {
+        u->mapa_cq = mmap(NULL, u->tam_mapa_cq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_CQ_RING);
+        if (u->mapa_cq == MAP_FAILED) goto fallo;
+    }
+    u->tam_sqes = p.sq_entries * sizeof(struct io_uring_sqe);
+    u->sqes = mmap(NULL, u->tam_sqes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQES);
+    if (u->sqes == MAP_FAILED) goto fallo;
+
+    unsigned char *sq = u->mapa_sq;
+    u->sq_cabeza = (unsigned *)(sq + p.sq_off.head);
+    u->sq_cola = (unsigned *)(sq + p.sq_off.tail);
+    u->sq_mascara = (unsigned *)(sq + p.sq_off.ring_mask);
+    u->sq_arreglo = (unsigned *)(sq + p.sq_off.array);
+    u->sq_cola_local = *u->sq_cola;
+
+    unsigned char *cq = u->mapa_cq;
+    u->cq_cabeza = (unsigned *)(cq + p.cq_off.head);
+    u->cq_cola = (unsigned *)(cq + p.cq_off.tail);
+    u->cq_mascara = (unsigned *)(cq + p.cq_off.ring_mask);
+    u->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    return 0;
+
+fallo:;
+    int err = errno;
+    if (u->mapa_sq != NULL && u->mapa_sq != MAP_FAILED) munmap(u->mapa_sq, u->tam_mapa_sq);
+    if (!un_mapeo && u->mapa_cq != NULL && u->mapa_cq != MAP_FAILED) munmap(u->mapa_cq, u->tam_mapa_cq);
+    close(u->fd);
+    u->fd = -1;
+    errno = err;
+    return -1;
+}
+
+static inline void uring_destruir(struct Uring *u) {
+    if (u->fd == -1) return;
+    munmap(u->sqes, u->tam_sqes);
+    if (u->mapa_cq != u->mapa_sq) munmap(u->mapa_cq, u->tam_mapa_cq);
+    munmap(u->mapa_sq, u->tam_mapa_sq);
+    close(u->fd);
+    u->fd = -1;
+}
+
+// Prepara un write de 'len' bytes en 'posicion'. Quien llama garantiza que no hay
+// mas de 'entradas' operaciones en vuelo, asi que siempre hay una SQE libre.
+static inline void uring_preparar_escritura(struct Uring *u, int fd, const void *datos, unsigned len,
+                                            long posicion, unsigned long long dato_usuario) {
+    unsigned indice = u->sq_cola_local & *u->sq_mascara;
+    struct io_uring_sqe *sqe = &u->sqes[indice];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->addr = (unsigned long)datos;
+    sqe->len = len;
+    sqe->off = posicion;
+    sqe->user_data = dato_usuario;
+    u->sq_arreglo[indice] = indice;
+    u->sq_cola_local++;
+    // Publicar la SQE antes de que el kernel vea la nueva cola
+    __atomic_store_n(u->sq_cola, u->sq_cola_local, __ATOMIC_RELEASE);
+    u->sin_enviar++;
+}
+
+// Envia las SQE publicadas con una sola syscall y, si min_completar > 0, espera
+// a que haya al menos esa cantidad de completados. Devuelve 0 o -1 con errno.
+static inline int uring_enviar(struct Uring *u, unsigned min_completar) {
+    unsigned banderas = min_completar > 0 ? IORING_ENTER_GETEVENTS : 0;
+    for (;;) {
+        long r = syscall(__NR_io_uring_enter, u->fd, u->sin_enviar, min_completar, banderas, NULL, 0);
+        if (r >= 0) {
+            u->sin_enviar -= (unsigned)r;
+            if (u->sin_enviar == 0 || min_completar == 0) return 0;
+            continue;
+        }
+        if (errno != EINTR) return -1;
+    }
+}
+
+// Saca un completado si hay alguno, sin syscall. Devuelve 1 y lo copia en *cqe, o 0.
+static inline int uring_cosechar(struct Uring *u, struct io_uring_cqe *cqe) {
+    unsigned cabeza = *u->cq_cabeza;
+    if (cabeza == __atomic_load_n(u->cq_cola, __ATOMIC_ACQUIRE)) return 0;
+    *cqe = u->cqes[cabeza & *u->cq_mascara];
+    __atomic_store_n(u->cq_cabeza, cabeza + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+#endif // URING_H